@@ -5,8 +5,41 @@
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <memory>
+#include <random>
+#include <cstdint>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <iterator>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <charconv>
+#include <cstdio>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TREE_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TREE_SIMD_SSE2
+#endif
+#define NOMINMAX
 #include <windows.h>
 
+#define TRAVERSAL_EXPLICIT_STACK 0
+#define TRAVERSAL_PARENT_LINKS 1
+#define TRAVERSAL_MORRIS 2
+#ifndef TREE_TRAVERSAL
+#define TREE_TRAVERSAL TRAVERSAL_PARENT_LINKS
+#endif
+
 namespace MenuConstants {
     const int MainMenu = 0;
     const int RandomMenu = 1;
@@ -14,217 +47,3591 @@ namespace MenuConstants {
     const int File2 = 3;
 }
 
-class Slider {
-public:
-    Slider(float x, float y, float width, float height, sf::Font& font) : minValue(0), maxValue(100000), currentValue(0), isDragging(false) {
-        track.setSize(sf::Vector2f(width, height / 4));
-        track.setPosition(x, y + height / 2 - track.getSize().y / 2);
-        track.setFillColor(sf::Color(200, 200, 200));
+namespace SortModes {
+    const int Basic = 0;
+    const int Compact = 1;
+    const int RedBlack = 2;
+    const int Avl = 3;
+    const int Scapegoat = 4;
+    const int Treap = 5;
+    const int WideNode = 6;
+    const int Finger = 7;
+    const int ParallelSample = 8;
+    const int ParallelMerge = 9;
+    const int ParallelCollect = 10;
+}
+
+namespace TreeLayouts {
+    const int InOrder = 0;
+    const int VanEmdeBoas = 1;
+}
+
+class Slider {
+public:
+    Slider(float x, float y, float width, float height, sf::Font& font) : minValue(0), maxValue(100000), currentValue(0), isDragging(false) {
+        track.setSize(sf::Vector2f(width, height / 4));
+        track.setPosition(x, y + height / 2 - track.getSize().y / 2);
+        track.setFillColor(sf::Color(200, 200, 200));
+
+        knob.setSize(sf::Vector2f(height, height));
+        knob.setOrigin(knob.getSize().x / 2, knob.getSize().y / 2);
+        knob.setPosition(x, y + height / 2);
+        knob.setFillColor(sf::Color(100, 100, 100));
+
+        valueText.setFont(font);
+        valueText.setCharacterSize(24);
+        valueText.setFillColor(sf::Color::Black);
+        valueText.setPosition(x, y - 30);
+        updateValueText();
+    }
+
+    void handleEvent(const sf::Event& event) {
+        if (event.type == sf::Event::MouseButtonPressed) {
+            sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
+            if (knob.getGlobalBounds().contains(mousePos)) {
+                isDragging = true;
+            }
+        }
+        else if (event.type == sf::Event::MouseButtonReleased) {
+            isDragging = false;
+        }
+        else if (event.type == sf::Event::MouseMoved) {
+            if (isDragging) {
+                float newX = static_cast<float>(event.mouseMove.x);
+                newX = std::max(track.getPosition().x, std::min(newX, track.getPosition().x + track.getSize().x));
+                knob.setPosition(newX, knob.getPosition().y);
+                currentValue = static_cast<int>(minValue + (maxValue - minValue) * ((newX - track.getPosition().x) / track.getSize().x));
+                updateValueText();
+            }
+        }
+    }
+
+    void draw(sf::RenderWindow& window) const {
+        window.draw(track);
+        window.draw(knob);
+        window.draw(valueText);
+    }
+
+    int getValue() const {
+        return currentValue;
+    }
+
+    void setValue(int value) {
+        currentValue = std::max(minValue, std::min(maxValue, value));
+        float newX = track.getPosition().x + track.getSize().x * ((currentValue - minValue) / static_cast<float>(maxValue - minValue));
+        knob.setPosition(newX, knob.getPosition().y);
+        updateValueText();
+    }
+
+private:
+    void updateValueText() {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(0) << currentValue;
+        valueText.setString(oss.str());
+    }
+
+    sf::RectangleShape track;
+    sf::RectangleShape knob;
+    sf::Text valueText;
+    int minValue;
+    int maxValue;
+    int currentValue;
+    bool isDragging;
+};
+
+struct Node {
+    static const bool HasSize = false;
+
+    int value;
+    int count = 1;
+    Node* left = nullptr;
+    Node* right = nullptr;
+    Node* parent = nullptr;
+};
+
+// Node plus the number of values in its subtree, for SortTree's order statistics and the parallel collect.
+// The pointer-tree functions below take either node type; only SizedNode pays for the extra store per level.
+struct SizedNode {
+    static const bool HasSize = true;
+
+    int value;
+    int count = 1;
+    SizedNode* left = nullptr;
+    SizedNode* right = nullptr;
+    SizedNode* parent = nullptr;
+    size_t size = 1;
+};
+
+template <typename T>
+class Arena {
+public:
+    explicit Arena(size_t nodesPerChunk = 16384) : chunkSize(nodesPerChunk), used(nodesPerChunk) {}
+
+    T* allocate() {
+        if (used == chunkSize) {
+            chunks.emplace_back(new T[chunkSize]);
+            used = 0;
+        }
+        return &chunks.back()[used++];
+    }
+
+    size_t getChunkCount() const {
+        return chunks.size();
+    }
+
+    size_t getNodeCount() const {
+        return chunks.empty() ? 0 : (chunks.size() - 1) * chunkSize + used;
+    }
+
+private:
+    std::vector<std::unique_ptr<T[]>> chunks;
+    size_t chunkSize;
+    size_t used;
+};
+
+typedef Arena<Node> NodeArena;
+typedef Arena<SizedNode> SizedNodeArena;
+
+template <typename TreeNode>
+TreeNode* createNode(Arena<TreeNode>& arena, int val, TreeNode* parent = nullptr) {
+    TreeNode* newNode = arena.allocate();
+    newNode->value = val;
+    newNode->parent = parent;
+    return newNode;
+}
+
+template <typename TreeNode>
+void insertNode(TreeNode*& root, int val, Arena<TreeNode>& arena) {
+    if (root == nullptr) {
+        root = createNode(arena, val);
+    }
+    else {
+        TreeNode* current = root;
+        TreeNode* parent = nullptr;
+        while (current != nullptr) {
+            if constexpr (TreeNode::HasSize) {
+                ++current->size;
+            }
+            if (val == current->value) {
+                ++current->count;
+                return;
+            }
+            parent = current;
+            if (val < current->value) {
+                current = current->left;
+            }
+            else {
+                current = current->right;
+            }
+        }
+        if (val < parent->value) {
+            parent->left = createNode(arena, val, parent);
+        }
+        else {
+            parent->right = createNode(arena, val, parent);
+        }
+    }
+}
+
+template <typename TreeNode>
+TreeNode* buildBinarySortTree(const std::vector<int>& arr, Arena<TreeNode>& arena) {
+    TreeNode* root = nullptr;
+    for (int val : arr) {
+        insertNode(root, val, arena);
+    }
+    return root;
+}
+
+// Remembers the last insertion point together with the open value interval (low, high) its subtree covers,
+// plus the current extremes of the tree, so runs and near-runs skip the descent from the root.
+// An insertion that skips the root cannot update the subtree sizes above its starting node, so it marks
+// them stale; recountSubtreeSizes repairs them in one pass before the next order-statistics query.
+template <typename TreeNode>
+struct BasicTreeFinger {
+    TreeNode* node = nullptr;
+    long long low = LLONG_MIN;
+    long long high = LLONG_MAX;
+    TreeNode* leftmost = nullptr;
+    TreeNode* rightmost = nullptr;
+    bool staleSizes = false;
+};
+
+typedef BasicTreeFinger<Node> TreeFinger;
+
+template <typename TreeNode>
+void insertNode(TreeNode*& root, int val, Arena<TreeNode>& arena, BasicTreeFinger<TreeNode>& finger) {
+    if (root == nullptr) {
+        root = createNode(arena, val);
+        finger.node = root;
+        finger.low = LLONG_MIN;
+        finger.high = LLONG_MAX;
+        finger.leftmost = root;
+        finger.rightmost = root;
+        return;
+    }
+    if (val > finger.rightmost->value) {
+        TreeNode* parent = finger.rightmost;
+        parent->right = createNode(arena, val, parent);
+        finger.node = parent->right;
+        finger.low = parent->value;
+        finger.high = LLONG_MAX;
+        finger.rightmost = parent->right;
+        finger.staleSizes = true;
+        return;
+    }
+    if (val < finger.leftmost->value) {
+        TreeNode* parent = finger.leftmost;
+        parent->left = createNode(arena, val, parent);
+        finger.node = parent->left;
+        finger.low = LLONG_MIN;
+        finger.high = parent->value;
+        finger.leftmost = parent->left;
+        finger.staleSizes = true;
+        return;
+    }
+
+    TreeNode* current = root;
+    long long low = LLONG_MIN;
+    long long high = LLONG_MAX;
+    if (finger.low < val && val < finger.high) {
+        current = finger.node;
+        low = finger.low;
+        high = finger.high;
+        finger.staleSizes = finger.staleSizes || current != root;
+    }
+    while (val != current->value) {
+        if constexpr (TreeNode::HasSize) {
+            ++current->size;
+        }
+        if (val < current->value) {
+            high = current->value;
+            if (current->left == nullptr) {
+                current->left = createNode(arena, val, current);
+                current->left->count = 0;
+                if constexpr (TreeNode::HasSize) {
+                    current->left->size = 0;
+                }
+            }
+            current = current->left;
+        }
+        else {
+            low = current->value;
+            if (current->right == nullptr) {
+                current->right = createNode(arena, val, current);
+                current->right->count = 0;
+                if constexpr (TreeNode::HasSize) {
+                    current->right->size = 0;
+                }
+            }
+            current = current->right;
+        }
+    }
+    ++current->count;
+    if constexpr (TreeNode::HasSize) {
+        ++current->size;
+    }
+    finger.node = current;
+    finger.low = low;
+    finger.high = high;
+}
+
+template <typename TreeNode>
+TreeNode* buildBinarySortTree(const std::vector<int>& arr, Arena<TreeNode>& arena, BasicTreeFinger<TreeNode>& finger) {
+    TreeNode* root = nullptr;
+    for (int val : arr) {
+        insertNode(root, val, arena, finger);
+    }
+    return root;
+}
+
+// Writes the tree in order into out, which must have room for every counted value, and returns the end.
+// None of the TREE_TRAVERSAL strategies recurse, so degenerate trees from sorted input are safe.
+// root may be any subtree; the traversal never leaves it.
+template <typename TreeNode>
+int* collectSortedValues(TreeNode* root, int* out) {
+#if TREE_TRAVERSAL == TRAVERSAL_EXPLICIT_STACK
+    std::vector<TreeNode*> stack;
+    TreeNode* current = root;
+    while (current != nullptr || !stack.empty()) {
+        while (current != nullptr) {
+            stack.push_back(current);
+            current = current->left;
+        }
+        current = stack.back();
+        stack.pop_back();
+        out = std::fill_n(out, current->count, current->value);
+        current = current->right;
+    }
+#elif TREE_TRAVERSAL == TRAVERSAL_PARENT_LINKS
+    TreeNode* current = root;
+    while (current != nullptr && current->left != nullptr) {
+        current = current->left;
+    }
+    while (current != nullptr) {
+        out = std::fill_n(out, current->count, current->value);
+        if (current->right != nullptr) {
+            current = current->right;
+            while (current->left != nullptr) {
+                current = current->left;
+            }
+        }
+        else {
+            TreeNode* child = current;
+            while (child != root && child->parent->right == child) {
+                child = child->parent;
+            }
+            current = child == root ? nullptr : child->parent;
+        }
+    }
+#elif TREE_TRAVERSAL == TRAVERSAL_MORRIS
+    TreeNode* current = root;
+    while (current != nullptr) {
+        if (current->left == nullptr) {
+            out = std::fill_n(out, current->count, current->value);
+            current = current->right;
+            continue;
+        }
+        TreeNode* predecessor = current->left;
+        while (predecessor->right != nullptr && predecessor->right != current) {
+            predecessor = predecessor->right;
+        }
+        if (predecessor->right == nullptr) {
+            predecessor->right = current;
+            current = current->left;
+        }
+        else {
+            predecessor->right = nullptr;
+            out = std::fill_n(out, current->count, current->value);
+            current = current->right;
+        }
+    }
+#else
+#error Unknown TREE_TRAVERSAL
+#endif
+    return out;
+}
+
+Node* findNode(Node* root, int val) {
+    Node* current = root;
+    while (current != nullptr && current->value != val) {
+        current = val < current->value ? current->left : current->right;
+    }
+    return current;
+}
+
+template <typename TreeNode>
+int treeHeight(TreeNode* root) {
+    int height = 0;
+    std::vector<std::pair<TreeNode*, int>> stack;
+    if (root != nullptr) {
+        stack.push_back({ root, 1 });
+    }
+    while (!stack.empty()) {
+        std::pair<TreeNode*, int> entry = stack.back();
+        stack.pop_back();
+        height = std::max(height, entry.second);
+        if (entry.first->left != nullptr) {
+            stack.push_back({ entry.first->left, entry.second + 1 });
+        }
+        if (entry.first->right != nullptr) {
+            stack.push_back({ entry.first->right, entry.second + 1 });
+        }
+    }
+    return height;
+}
+
+template <typename TreeNode>
+void collectInOrderNodes(TreeNode* root, std::vector<TreeNode*>& order) {
+    std::vector<TreeNode*> stack;
+    TreeNode* current = root;
+    while (current != nullptr || !stack.empty()) {
+        while (current != nullptr) {
+            stack.push_back(current);
+            current = current->left;
+        }
+        current = stack.back();
+        stack.pop_back();
+        order.push_back(current);
+        current = current->right;
+    }
+}
+
+// Lays out the top half of the levels first, then each subtree hanging below it, recursively.
+template <typename TreeNode>
+void collectVanEmdeBoasNodes(TreeNode* root, int height, std::vector<TreeNode*>& order) {
+    if (height == 1) {
+        order.push_back(root);
+        return;
+    }
+    int topHeight = height / 2;
+    collectVanEmdeBoasNodes(root, topHeight, order);
+
+    std::vector<TreeNode*> bottomRoots;
+    std::vector<std::pair<TreeNode*, int>> stack;
+    stack.push_back({ root, 0 });
+    while (!stack.empty()) {
+        std::pair<TreeNode*, int> entry = stack.back();
+        stack.pop_back();
+        if (entry.second == topHeight) {
+            bottomRoots.push_back(entry.first);
+            continue;
+        }
+        if (entry.first->right != nullptr) {
+            stack.push_back({ entry.first->right, entry.second + 1 });
+        }
+        if (entry.first->left != nullptr) {
+            stack.push_back({ entry.first->left, entry.second + 1 });
+        }
+    }
+    for (TreeNode* bottomRoot : bottomRoots) {
+        collectVanEmdeBoasNodes(bottomRoot, height - topHeight, order);
+    }
+}
+
+// Copies the tree into one contiguous block in the requested order and returns the new root.
+// The parent links of the source tree are reused as forwarding pointers, so it must not be used afterwards.
+template <typename TreeNode>
+TreeNode* relayoutTree(TreeNode* root, std::vector<TreeNode>& block, int layout) {
+    block.clear();
+    if (root == nullptr) {
+        return nullptr;
+    }
+    std::vector<TreeNode*> order;
+    if (layout == TreeLayouts::VanEmdeBoas) {
+        collectVanEmdeBoasNodes(root, treeHeight(root), order);
+    }
+    else {
+        collectInOrderNodes(root, order);
+    }
+
+    block.resize(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        block[i] = *order[i];
+        order[i]->parent = &block[i];
+    }
+    for (TreeNode& node : block) {
+        node.left = node.left != nullptr ? node.left->parent : nullptr;
+        node.right = node.right != nullptr ? node.right->parent : nullptr;
+    }
+    for (TreeNode& node : block) {
+        if (node.left != nullptr) {
+            node.left->parent = &node;
+        }
+        if (node.right != nullptr) {
+            node.right->parent = &node;
+        }
+    }
+    TreeNode* newRoot = root->parent;
+    newRoot->parent = nullptr;
+    return newRoot;
+}
+
+inline size_t subtreeSize(const SizedNode* node) {
+    return node == nullptr ? 0 : node->size;
+}
+
+void recountSubtreeSizes(SizedNode* root) {
+    std::vector<SizedNode*> preorder;
+    std::vector<SizedNode*> stack;
+    if (root != nullptr) {
+        stack.push_back(root);
+    }
+    while (!stack.empty()) {
+        SizedNode* node = stack.back();
+        stack.pop_back();
+        preorder.push_back(node);
+        if (node->left != nullptr) {
+            stack.push_back(node->left);
+        }
+        if (node->right != nullptr) {
+            stack.push_back(node->right);
+        }
+    }
+    for (size_t i = preorder.size(); i-- > 0;) {
+        SizedNode* node = preorder[i];
+        node->size = node->count + subtreeSize(node->left) + subtreeSize(node->right);
+    }
+}
+
+// Returns the node holding the k-th smallest value (0-based, duplicates counted) and the position of
+// that value among the node's copies.
+SizedNode* selectNode(SizedNode* root, size_t k, size_t& repeat) {
+    SizedNode* current = root;
+    while (current != nullptr) {
+        size_t leftSize = subtreeSize(current->left);
+        if (k < leftSize) {
+            current = current->left;
+        }
+        else if (k < leftSize + current->count) {
+            repeat = k - leftSize;
+            return current;
+        }
+        else {
+            k -= leftSize + current->count;
+            current = current->right;
+        }
+    }
+    return nullptr;
+}
+
+// Returns how many values in the tree are smaller than val.
+size_t rankOf(SizedNode* root, int val) {
+    size_t rank = 0;
+    SizedNode* current = root;
+    while (current != nullptr) {
+        if (val <= current->value) {
+            if (val == current->value) {
+                return rank + subtreeSize(current->left);
+            }
+            current = current->left;
+        }
+        else {
+            rank += subtreeSize(current->left) + current->count;
+            current = current->right;
+        }
+    }
+    return rank;
+}
+
+template <typename TreeNode>
+TreeNode* nextInOrder(TreeNode* node) {
+    if (node->right != nullptr) {
+        node = node->right;
+        while (node->left != nullptr) {
+            node = node->left;
+        }
+        return node;
+    }
+    TreeNode* child = node;
+    node = node->parent;
+    while (node != nullptr && node->right == child) {
+        child = node;
+        node = node->parent;
+    }
+    return node;
+}
+
+// 0-based index of the nearest-rank percentile among count sorted values. percent must lie in [0, 100].
+inline size_t nearestRankIndex(double percent, size_t count) {
+    if (!(percent >= 0.0 && percent <= 100.0)) {
+        throw std::out_of_range("percentile must be between 0 and 100");
+    }
+    double position = std::ceil(percent / 100.0 * count);
+    size_t k = position <= 1.0 ? 0 : static_cast<size_t>(position) - 1;
+    return std::min(k, count == 0 ? 0 : count - 1);
+}
+
+// Owns a finger-inserted pointer tree and hands its values out lazily in sorted order.
+class SortTree {
+public:
+    class Iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef int value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const int* pointer;
+        typedef const int& reference;
+
+        explicit Iterator(SizedNode* node = nullptr, int repeat = 0) : node(node), repeat(repeat) {}
+
+        const int& operator*() const {
+            return node->value;
+        }
+
+        Iterator& operator++() {
+            if (++repeat == node->count) {
+                node = nextInOrder(node);
+                repeat = 0;
+            }
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return node == other.node && repeat == other.repeat;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        SizedNode* node;
+        int repeat;
+    };
+
+    SortTree() : root(nullptr), count(0) {}
+
+    explicit SortTree(const std::vector<int>& arr) : SortTree() {
+        for (int val : arr) {
+            insert(val);
+        }
+    }
+
+    void insert(int val) {
+        insertNode(root, val, arena, finger);
+        ++count;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    Iterator begin() const {
+        SizedNode* node = root;
+        while (node != nullptr && node->left != nullptr) {
+            node = node->left;
+        }
+        return Iterator(node);
+    }
+
+    Iterator end() const {
+        return Iterator();
+    }
+
+    Iterator lower_bound(int val) const {
+        SizedNode* candidate = nullptr;
+        SizedNode* current = root;
+        while (current != nullptr) {
+            if (current->value >= val) {
+                candidate = current;
+                current = current->left;
+            }
+            else {
+                current = current->right;
+            }
+        }
+        return Iterator(candidate);
+    }
+
+    Iterator upper_bound(int val) const {
+        SizedNode* candidate = nullptr;
+        SizedNode* current = root;
+        while (current != nullptr) {
+            if (current->value > val) {
+                candidate = current;
+                current = current->left;
+            }
+            else {
+                current = current->right;
+            }
+        }
+        return Iterator(candidate);
+    }
+
+    // Order statistics run in O(log n). Finger insertions that skip the root leave the subtree sizes stale, so
+    // the first query after them recounts the sizes once. k is 0-based; percentiles use the nearest-rank definition.
+    int select(size_t k) {
+        if (k >= count) {
+            throw std::out_of_range("SortTree::select index out of range");
+        }
+        refreshSizes();
+        size_t repeat = 0;
+        return selectNode(root, k, repeat)->value;
+    }
+
+    size_t rank(int val) {
+        refreshSizes();
+        return rankOf(root, val);
+    }
+
+    int median() {
+        return select(count == 0 ? 0 : (count - 1) / 2);
+    }
+
+    int percentile(double percent) {
+        return select(nearestRankIndex(percent, count));
+    }
+
+    // Moves the nodes into one contiguous block (see relayoutTree) for query-heavy use.
+    // Values inserted afterwards still come from the arena and link into the block.
+    void relayout(int layout) {
+        if (root == nullptr) {
+            return;
+        }
+        std::vector<SizedNode> newBlock;
+        root = relayoutTree(root, newBlock, layout);
+        finger.node = finger.node->parent;
+        finger.leftmost = finger.leftmost->parent;
+        finger.rightmost = finger.rightmost->parent;
+        block.swap(newBlock);
+    }
+
+private:
+    void refreshSizes() {
+        if (finger.staleSizes) {
+            recountSubtreeSizes(root);
+            finger.staleSizes = false;
+        }
+    }
+
+    SizedNodeArena arena;
+    std::vector<SizedNode> block;
+    BasicTreeFinger<SizedNode> finger;
+    SizedNode* root;
+    size_t count;
+};
+
+struct ConcurrentNode {
+    int value;
+    std::atomic<uint32_t> count;
+    std::atomic<ConcurrentNode*> child[2];
+};
+
+// Unbalanced tree shared by several inserting threads without a lock. A new node is published with one CAS on
+// the empty link it hangs from and a duplicate only bumps an atomic count. Nodes never move or go away, so
+// there is nothing to reclaim. Each producer allocates from its own arena and passes its number to insert.
+class ConcurrentTree {
+public:
+    explicit ConcurrentTree(unsigned producers) : root(nullptr) {
+        for (unsigned i = 0; i < producers; ++i) {
+            arenas.emplace_back(new Arena<ConcurrentNode>());
+        }
+    }
+
+    void insert(int val, unsigned producer) {
+        std::atomic<ConcurrentNode*>* link = &root;
+        ConcurrentNode* created = nullptr;
+        while (true) {
+            ConcurrentNode* current = link->load(std::memory_order_acquire);
+            if (current == nullptr) {
+                if (created == nullptr) {
+                    created = arenas[producer]->allocate();
+                    created->value = val;
+                    created->count.store(1, std::memory_order_relaxed);
+                    created->child[0].store(nullptr, std::memory_order_relaxed);
+                    created->child[1].store(nullptr, std::memory_order_relaxed);
+                }
+                if (link->compare_exchange_weak(current, created, std::memory_order_release, std::memory_order_acquire)) {
+                    return;
+                }
+                continue;
+            }
+            if (val == current->value) {
+                current->count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            link = &current->child[val < current->value ? 0 : 1];
+        }
+    }
+
+    // Only valid at a quiescent point, once every inserting thread has been joined.
+    void collectSortedValues(std::vector<int>& sortedArray) const {
+        std::vector<const ConcurrentNode*> stack;
+        const ConcurrentNode* current = root.load(std::memory_order_relaxed);
+        while (current != nullptr || !stack.empty()) {
+            while (current != nullptr) {
+                stack.push_back(current);
+                current = current->child[0].load(std::memory_order_relaxed);
+            }
+            current = stack.back();
+            stack.pop_back();
+            sortedArray.insert(sortedArray.end(), current->count.load(std::memory_order_relaxed), current->value);
+            current = current->child[1].load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<Arena<ConcurrentNode>>> arenas;
+    std::atomic<ConcurrentNode*> root;
+};
+
+const uint32_t NullIndex = 0xFFFFFFFF;
+
+struct CompactNode {
+    int value;
+    uint32_t count;
+    uint32_t child[2];
+};
+
+struct CompactTree {
+    std::vector<CompactNode> nodes;
+    uint32_t root = NullIndex;
+};
+
+void insertNode(CompactTree& tree, int val) {
+    uint32_t parent = NullIndex;
+    int dir = 0;
+    uint32_t current = tree.root;
+    while (current != NullIndex) {
+        CompactNode& node = tree.nodes[current];
+        if (val == node.value) {
+            ++node.count;
+            return;
+        }
+        parent = current;
+        dir = val < node.value ? 0 : 1;
+        current = node.child[dir];
+    }
+    uint32_t index = static_cast<uint32_t>(tree.nodes.size());
+    tree.nodes.push_back({ val, 1, { NullIndex, NullIndex } });
+    if (parent == NullIndex) {
+        tree.root = index;
+    }
+    else {
+        tree.nodes[parent].child[dir] = index;
+    }
+}
+
+void buildBinarySortTree(const std::vector<int>& arr, CompactTree& tree) {
+    tree.nodes.reserve(tree.nodes.size() + arr.size());
+    for (int val : arr) {
+        insertNode(tree, val);
+    }
+}
+
+void collectSortedValues(const CompactTree& tree, std::vector<int>& sortedArray) {
+    std::vector<uint32_t> stack;
+    uint32_t current = tree.root;
+    while (current != NullIndex || !stack.empty()) {
+        while (current != NullIndex) {
+            stack.push_back(current);
+            current = tree.nodes[current].child[0];
+        }
+        current = stack.back();
+        stack.pop_back();
+        sortedArray.insert(sortedArray.end(), tree.nodes[current].count, tree.nodes[current].value);
+        current = tree.nodes[current].child[1];
+    }
+}
+
+struct TreePathStep {
+    uint32_t node;
+    int dir;
+};
+
+// Counted trees keep a subtree size per node in `sizes`, which is what selectValue needs.
+template <typename Policy, typename Key = int, typename Compare = std::less<Key>, bool Counted = false>
+struct BalancedTree {
+    struct BalancedNode {
+        Key value;
+        uint32_t child[2];
+        typename Policy::NodeData data;
+    };
+
+    std::vector<BalancedNode> nodes;
+    uint32_t root = NullIndex;
+    Policy policy;
+    Compare compare;
+    std::vector<TreePathStep> path;
+    std::vector<uint32_t> freeNodes;
+    std::vector<uint32_t> sizes;
+
+    uint32_t sizeOf(uint32_t index) const {
+        return index == NullIndex ? 0 : sizes[index];
+    }
+
+    void updateSize(uint32_t index) {
+        if constexpr (Counted) {
+            sizes[index] = 1 + sizeOf(nodes[index].child[0]) + sizeOf(nodes[index].child[1]);
+        }
+    }
+
+    uint32_t& linkAt(size_t depth) {
+        if (depth == 0) {
+            return root;
+        }
+        const TreePathStep& step = path[depth - 1];
+        return nodes[step.node].child[step.dir];
+    }
+
+    uint32_t rotate(uint32_t top, int dir) {
+        uint32_t pivot = nodes[top].child[1 - dir];
+        nodes[top].child[1 - dir] = nodes[pivot].child[dir];
+        nodes[pivot].child[dir] = top;
+        updateSize(top);
+        updateSize(pivot);
+        return pivot;
+    }
+
+    template <typename Visit>
+    void forEachInOrder(uint32_t start, Visit visit) const {
+        std::vector<uint32_t> stack;
+        uint32_t current = start;
+        while (current != NullIndex || !stack.empty()) {
+            while (current != NullIndex) {
+                stack.push_back(current);
+                current = nodes[current].child[0];
+            }
+            current = stack.back();
+            stack.pop_back();
+            visit(current);
+            current = nodes[current].child[1];
+        }
+    }
+};
+
+struct RedBlackPolicy {
+    typedef uint8_t NodeData;
+
+    static const NodeData Black = 0;
+    static const NodeData Red = 1;
+
+    NodeData newNodeData(uint32_t) const {
+        return Red;
+    }
+
+    template <typename Tree>
+    void afterInsert(Tree& tree, uint32_t) {
+        size_t depth = tree.path.size();
+        while (depth >= 2) {
+            uint32_t parent = tree.path[depth - 1].node;
+            if (tree.nodes[parent].data != Red) {
+                break;
+            }
+            uint32_t grandparent = tree.path[depth - 2].node;
+            int side = tree.path[depth - 2].dir;
+            uint32_t uncle = tree.nodes[grandparent].child[1 - side];
+            if (uncle != NullIndex && tree.nodes[uncle].data == Red) {
+                tree.nodes[parent].data = Black;
+                tree.nodes[uncle].data = Black;
+                tree.nodes[grandparent].data = Red;
+                depth -= 2;
+                continue;
+            }
+            if (tree.path[depth - 1].dir != side) {
+                tree.nodes[grandparent].child[side] = tree.rotate(parent, side);
+            }
+            uint32_t top = tree.rotate(grandparent, 1 - side);
+            tree.nodes[top].data = Black;
+            tree.nodes[grandparent].data = Red;
+            tree.linkAt(depth - 2) = top;
+            break;
+        }
+        tree.nodes[tree.root].data = Black;
+    }
+
+    template <typename Tree>
+    static bool isRed(const Tree& tree, uint32_t index) {
+        return index != NullIndex && tree.nodes[index].data == Red;
+    }
+
+    template <typename Tree>
+    void afterErase(Tree& tree, uint32_t replacement, NodeData removed) {
+        if (removed == Red) {
+            return;
+        }
+        size_t depth = tree.path.size();
+        uint32_t current = replacement;
+        while (depth > 0 && !isRed(tree, current)) {
+            uint32_t parent = tree.path[depth - 1].node;
+            int side = tree.path[depth - 1].dir;
+            uint32_t sibling = tree.nodes[parent].child[1 - side];
+            if (isRed(tree, sibling)) {
+                uint32_t top = tree.rotate(parent, side);
+                tree.nodes[top].data = Black;
+                tree.nodes[parent].data = Red;
+                tree.linkAt(depth - 1) = top;
+                tree.path.insert(tree.path.begin() + (depth - 1), TreePathStep{ top, side });
+                ++depth;
+                sibling = tree.nodes[parent].child[1 - side];
+            }
+            uint32_t nearChild = tree.nodes[sibling].child[side];
+            if (!isRed(tree, nearChild) && !isRed(tree, tree.nodes[sibling].child[1 - side])) {
+                tree.nodes[sibling].data = Red;
+                current = parent;
+                --depth;
+                continue;
+            }
+            if (!isRed(tree, tree.nodes[sibling].child[1 - side])) {
+                tree.nodes[parent].child[1 - side] = tree.rotate(sibling, 1 - side);
+                tree.nodes[nearChild].data = Black;
+                tree.nodes[sibling].data = Red;
+                sibling = nearChild;
+            }
+            uint32_t top = tree.rotate(parent, side);
+            tree.nodes[top].data = tree.nodes[parent].data;
+            tree.nodes[parent].data = Black;
+            tree.nodes[tree.nodes[top].child[1 - side]].data = Black;
+            tree.linkAt(depth - 1) = top;
+            current = tree.root;
+            break;
+        }
+        if (current != NullIndex) {
+            tree.nodes[current].data = Black;
+        }
+    }
+};
+
+struct AvlPolicy {
+    typedef int8_t NodeData;
+
+    NodeData newNodeData(uint32_t) const {
+        return 1;
+    }
+
+    template <typename Tree>
+    static int height(const Tree& tree, uint32_t index) {
+        return index == NullIndex ? 0 : tree.nodes[index].data;
+    }
+
+    template <typename Tree>
+    static void updateHeight(Tree& tree, uint32_t index) {
+        const uint32_t* child = tree.nodes[index].child;
+        tree.nodes[index].data = static_cast<NodeData>(1 + std::max(height(tree, child[0]), height(tree, child[1])));
+    }
+
+    template <typename Tree>
+    static uint32_t rebalance(Tree& tree, uint32_t index) {
+        updateHeight(tree, index);
+        int balance = height(tree, tree.nodes[index].child[0]) - height(tree, tree.nodes[index].child[1]);
+        if (balance >= -1 && balance <= 1) {
+            return index;
+        }
+        int heavy = balance > 0 ? 0 : 1;
+        uint32_t child = tree.nodes[index].child[heavy];
+        if (height(tree, tree.nodes[child].child[1 - heavy]) > height(tree, tree.nodes[child].child[heavy])) {
+            uint32_t inner = tree.rotate(child, heavy);
+            tree.nodes[index].child[heavy] = inner;
+            updateHeight(tree, child);
+            updateHeight(tree, inner);
+        }
+        uint32_t top = tree.rotate(index, 1 - heavy);
+        updateHeight(tree, index);
+        updateHeight(tree, top);
+        return top;
+    }
+
+    template <typename Tree>
+    void afterInsert(Tree& tree, uint32_t) {
+        for (size_t depth = tree.path.size(); depth-- > 0;) {
+            uint32_t index = tree.path[depth].node;
+            int oldHeight = tree.nodes[index].data;
+            uint32_t top = rebalance(tree, index);
+            if (top != index) {
+                tree.linkAt(depth) = top;
+                break;
+            }
+            if (tree.nodes[index].data == oldHeight) {
+                break;
+            }
+        }
+    }
+
+    template <typename Tree>
+    void afterErase(Tree& tree, uint32_t, NodeData) {
+        for (size_t depth = tree.path.size(); depth-- > 0;) {
+            uint32_t index = tree.path[depth].node;
+            uint32_t top = rebalance(tree, index);
+            if (top != index) {
+                tree.linkAt(depth) = top;
+            }
+        }
+    }
+};
+
+struct ScapegoatPolicy {
+    struct NodeData {};
+
+    const double Alpha = 0.7;
+    size_t size = 0;
+    size_t maxSize = 0;
+    std::vector<uint32_t> order;
+
+    NodeData newNodeData(uint32_t) const {
+        return NodeData();
+    }
+
+    template <typename Tree>
+    static size_t subtreeSize(const Tree& tree, uint32_t index) {
+        size_t count = 0;
+        tree.forEachInOrder(index, [&](uint32_t) { ++count; });
+        return count;
+    }
+
+    template <typename Tree>
+    static uint32_t buildBalanced(Tree& tree, const uint32_t* indices, size_t count) {
+        if (count == 0) {
+            return NullIndex;
+        }
+        size_t middle = count / 2;
+        uint32_t index = indices[middle];
+        tree.nodes[index].child[0] = buildBalanced(tree, indices, middle);
+        tree.nodes[index].child[1] = buildBalanced(tree, indices + middle + 1, count - middle - 1);
+        tree.updateSize(index);
+        return index;
+    }
+
+    template <typename Tree>
+    uint32_t rebuild(Tree& tree, uint32_t index) {
+        order.clear();
+        tree.forEachInOrder(index, [&](uint32_t visited) { order.push_back(visited); });
+        return buildBalanced(tree, order.data(), order.size());
+    }
+
+    template <typename Tree>
+    void afterInsert(Tree& tree, uint32_t) {
+        ++size;
+        maxSize = std::max(maxSize, size);
+        size_t depth = tree.path.size();
+        if (depth <= std::log(static_cast<double>(size)) / -std::log(Alpha)) {
+            return;
+        }
+        size_t childSize = 1;
+        for (size_t level = depth; level-- > 0;) {
+            const TreePathStep& step = tree.path[level];
+            size_t nodeSize = childSize + 1 + subtreeSize(tree, tree.nodes[step.node].child[1 - step.dir]);
+            if (childSize > Alpha * nodeSize) {
+                tree.linkAt(level) = rebuild(tree, step.node);
+                return;
+            }
+            childSize = nodeSize;
+        }
+    }
+
+    template <typename Tree>
+    void afterErase(Tree& tree, uint32_t, NodeData) {
+        --size;
+        if (size < Alpha * maxSize) {
+            tree.root = rebuild(tree, tree.root);
+            maxSize = size;
+        }
+    }
+};
+
+const uint32_t DefaultTreapSeed = 0x2545F491;
+
+inline uint32_t hashPriority(uint32_t index, uint32_t seed) {
+    uint32_t hash = index ^ (seed * 0x9E3779B9u);
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+struct TreapPolicy {
+    typedef uint32_t NodeData;
+
+    uint32_t seed = DefaultTreapSeed;
+
+    NodeData newNodeData(uint32_t index) const {
+        return hashPriority(index, seed);
+    }
+
+    template <typename Tree>
+    void afterInsert(Tree& tree, uint32_t inserted) {
+        for (size_t depth = tree.path.size(); depth-- > 0;) {
+            const TreePathStep& step = tree.path[depth];
+            if (tree.nodes[step.node].data >= tree.nodes[inserted].data) {
+                break;
+            }
+            tree.linkAt(depth) = tree.rotate(step.node, 1 - step.dir);
+        }
+    }
+
+    // eraseNode only splices out a node with at most one child, which keeps the heap order intact.
+    template <typename Tree>
+    void afterErase(Tree&, uint32_t, NodeData) {
+    }
+};
+
+// Equal keys descend to the right and rebalancing only rotates or rebuilds without reordering, so nodes with
+// equal keys come out of forEachInOrder in insertion order. The record sorts below rely on that, which is why
+// these trees keep a node per duplicate instead of a count like Node and CompactNode.
+template <typename Policy, typename Key, typename Compare, bool Counted>
+void attachNode(BalancedTree<Policy, Key, Compare, Counted>& tree, uint32_t index) {
+    const Key& val = tree.nodes[index].value;
+    tree.path.clear();
+    uint32_t current = tree.root;
+    while (current != NullIndex) {
+        int dir = tree.compare(val, tree.nodes[current].value) ? 0 : 1;
+        tree.path.push_back({ current, dir });
+        current = tree.nodes[current].child[dir];
+    }
+    tree.linkAt(tree.path.size()) = index;
+    if constexpr (Counted) {
+        for (const TreePathStep& step : tree.path) {
+            ++tree.sizes[step.node];
+        }
+        tree.sizes[index] = 1;
+    }
+    tree.policy.afterInsert(tree, index);
+}
+
+// Slots freed by eraseNode are reused before the node vector grows.
+template <typename Policy, typename Key, typename Compare, bool Counted>
+void insertNode(BalancedTree<Policy, Key, Compare, Counted>& tree, const Key& val) {
+    uint32_t index;
+    if (!tree.freeNodes.empty()) {
+        index = tree.freeNodes.back();
+        tree.freeNodes.pop_back();
+        tree.nodes[index] = { val, { NullIndex, NullIndex }, tree.policy.newNodeData(index) };
+    }
+    else {
+        index = static_cast<uint32_t>(tree.nodes.size());
+        tree.nodes.push_back({ val, { NullIndex, NullIndex }, tree.policy.newNodeData(index) });
+        if constexpr (Counted) {
+            tree.sizes.push_back(1);
+        }
+    }
+    attachNode(tree, index);
+}
+
+// Removes one node equal to val and returns false if there is none. A node with two children takes its
+// successor's value and the successor's slot is unlinked instead, so node indices do not keep their values.
+template <typename Policy, typename Key, typename Compare, bool Counted>
+bool eraseNode(BalancedTree<Policy, Key, Compare, Counted>& tree, const Key& val) {
+    tree.path.clear();
+    uint32_t current = tree.root;
+    while (current != NullIndex) {
+        const Key& key = tree.nodes[current].value;
+        int dir;
+        if (tree.compare(val, key)) {
+            dir = 0;
+        }
+        else if (tree.compare(key, val)) {
+            dir = 1;
+        }
+        else {
+            break;
+        }
+        tree.path.push_back({ current, dir });
+        current = tree.nodes[current].child[dir];
+    }
+    if (current == NullIndex) {
+        return false;
+    }
+
+    uint32_t removed = current;
+    if (tree.nodes[current].child[0] != NullIndex && tree.nodes[current].child[1] != NullIndex) {
+        tree.path.push_back({ current, 1 });
+        removed = tree.nodes[current].child[1];
+        while (tree.nodes[removed].child[0] != NullIndex) {
+            tree.path.push_back({ removed, 0 });
+            removed = tree.nodes[removed].child[0];
+        }
+        tree.nodes[current].value = tree.nodes[removed].value;
+    }
+    const uint32_t* child = tree.nodes[removed].child;
+    uint32_t replacement = child[0] != NullIndex ? child[0] : child[1];
+    tree.linkAt(tree.path.size()) = replacement;
+    if constexpr (Counted) {
+        for (const TreePathStep& step : tree.path) {
+            --tree.sizes[step.node];
+        }
+    }
+    tree.policy.afterErase(tree, replacement, tree.nodes[removed].data);
+    tree.freeNodes.push_back(removed);
+    return true;
+}
+
+template <typename Policy, typename Key, typename Compare>
+const Key& selectValue(const BalancedTree<Policy, Key, Compare, true>& tree, size_t k) {
+    uint32_t current = tree.root;
+    while (true) {
+        size_t leftSize = tree.sizeOf(tree.nodes[current].child[0]);
+        if (k < leftSize) {
+            current = tree.nodes[current].child[0];
+        }
+        else if (k == leftSize) {
+            return tree.nodes[current].value;
+        }
+        else {
+            k -= leftSize + 1;
+            current = tree.nodes[current].child[1];
+        }
+    }
+}
+
+template <typename Policy, typename Key, typename Compare, bool Counted>
+void buildBinarySortTree(const std::vector<Key>& arr, BalancedTree<Policy, Key, Compare, Counted>& tree) {
+    tree.nodes.reserve(tree.nodes.size() + arr.size());
+    for (const Key& val : arr) {
+        insertNode(tree, val);
+    }
+}
+
+template <typename Policy, typename Key, typename Compare, bool Counted>
+void collectSortedValues(const BalancedTree<Policy, Key, Compare, Counted>& tree, std::vector<Key>& sortedArray) {
+    tree.forEachInOrder(tree.root, [&](uint32_t index) { sortedArray.push_back(tree.nodes[index].value); });
+}
+
+const int BTreeMinDegree = 16;
+const int BTreeMaxKeys = 2 * BTreeMinDegree - 1;
+const int BTreeKeySlots = 2 * BTreeMinDegree;
+
+struct alignas(64) BTreeNode {
+    int keys[BTreeKeySlots];
+    uint32_t children[BTreeKeySlots];
+    int count;
+    bool leaf;
+};
+
+inline int countBits(uint32_t mask) {
+    mask = mask - ((mask >> 1) & 0x55555555u);
+    mask = (mask & 0x33333333u) + ((mask >> 2) & 0x33333333u);
+    return static_cast<int>((((mask + (mask >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+// Unused key slots hold INT_MAX, so all BTreeKeySlots keys can be compared at once.
+inline int upperBoundInNode(const int* keys, int count, int val) {
+#if defined(TREE_SIMD_AVX2)
+    __m256i needle = _mm256_set1_epi32(val);
+    uint32_t greater = 0;
+    for (int i = 0; i < BTreeKeySlots; i += 8) {
+        __m256i block = _mm256_load_si256(reinterpret_cast<const __m256i*>(keys + i));
+        greater |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(block, needle)))) << i;
+    }
+    return std::min(BTreeKeySlots - countBits(greater), count);
+#elif defined(TREE_SIMD_SSE2)
+    __m128i needle = _mm_set1_epi32(val);
+    uint32_t greater = 0;
+    for (int i = 0; i < BTreeKeySlots; i += 4) {
+        __m128i block = _mm_load_si128(reinterpret_cast<const __m128i*>(keys + i));
+        greater |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(block, needle)))) << i;
+    }
+    return std::min(BTreeKeySlots - countBits(greater), count);
+#else
+    return static_cast<int>(std::upper_bound(keys, keys + count, val) - keys);
+#endif
+}
+
+struct BTree {
+    std::vector<BTreeNode> nodes;
+    uint32_t root = NullIndex;
+
+    uint32_t allocateNode(bool leaf) {
+        uint32_t index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        BTreeNode& node = nodes.back();
+        std::fill(node.keys, node.keys + BTreeKeySlots, INT_MAX);
+        node.count = 0;
+        node.leaf = leaf;
+        return index;
+    }
+
+    void splitChild(uint32_t parent, int position) {
+        uint32_t full = nodes[parent].children[position];
+        uint32_t sibling = allocateNode(nodes[full].leaf);
+        BTreeNode& left = nodes[full];
+        BTreeNode& right = nodes[sibling];
+        BTreeNode& top = nodes[parent];
+
+        std::copy(left.keys + BTreeMinDegree, left.keys + BTreeMaxKeys, right.keys);
+        if (!left.leaf) {
+            std::copy(left.children + BTreeMinDegree, left.children + BTreeMaxKeys + 1, right.children);
+        }
+        right.count = BTreeMinDegree - 1;
+        int median = left.keys[BTreeMinDegree - 1];
+        std::fill(left.keys + BTreeMinDegree - 1, left.keys + BTreeMaxKeys, INT_MAX);
+        left.count = BTreeMinDegree - 1;
+
+        std::copy_backward(top.keys + position, top.keys + top.count, top.keys + top.count + 1);
+        std::copy_backward(top.children + position + 1, top.children + top.count + 1, top.children + top.count + 2);
+        top.keys[position] = median;
+        top.children[position + 1] = sibling;
+        ++top.count;
+    }
+};
+
+// Duplicates take a key slot each: a count per key would halve how many keys fit in a node's cache lines.
+void insertNode(BTree& tree, int val) {
+    if (tree.root == NullIndex) {
+        tree.root = tree.allocateNode(true);
+    }
+    if (tree.nodes[tree.root].count == BTreeMaxKeys) {
+        uint32_t newRoot = tree.allocateNode(false);
+        tree.nodes[newRoot].children[0] = tree.root;
+        tree.root = newRoot;
+        tree.splitChild(newRoot, 0);
+    }
+    uint32_t current = tree.root;
+    while (!tree.nodes[current].leaf) {
+        int position = upperBoundInNode(tree.nodes[current].keys, tree.nodes[current].count, val);
+        uint32_t child = tree.nodes[current].children[position];
+        if (tree.nodes[child].count == BTreeMaxKeys) {
+            tree.splitChild(current, position);
+            if (!(val < tree.nodes[current].keys[position])) {
+                ++position;
+            }
+            child = tree.nodes[current].children[position];
+        }
+        current = child;
+    }
+    BTreeNode& leaf = tree.nodes[current];
+    int position = upperBoundInNode(leaf.keys, leaf.count, val);
+    std::copy_backward(leaf.keys + position, leaf.keys + leaf.count, leaf.keys + leaf.count + 1);
+    leaf.keys[position] = val;
+    ++leaf.count;
+}
+
+void buildBinarySortTree(const std::vector<int>& arr, BTree& tree) {
+    tree.nodes.reserve(tree.nodes.size() + arr.size() / BTreeMinDegree + 1);
+    for (int val : arr) {
+        insertNode(tree, val);
+    }
+}
+
+void collectSortedValues(const BTree& tree, uint32_t index, std::vector<int>& sortedArray) {
+    const BTreeNode& node = tree.nodes[index];
+    if (node.leaf) {
+        sortedArray.insert(sortedArray.end(), node.keys, node.keys + node.count);
+        return;
+    }
+    for (int i = 0; i < node.count; ++i) {
+        collectSortedValues(tree, node.children[i], sortedArray);
+        sortedArray.push_back(node.keys[i]);
+    }
+    collectSortedValues(tree, node.children[node.count], sortedArray);
+}
+
+void collectSortedValues(const BTree& tree, std::vector<int>& sortedArray) {
+    if (tree.root != NullIndex) {
+        collectSortedValues(tree, tree.root, sortedArray);
+    }
+}
+
+template <typename Tree>
+void sortWithTree(const std::vector<int>& arr, std::vector<int>& sortedArray) {
+    Tree tree;
+    buildBinarySortTree(arr, tree);
+    collectSortedValues(tree, sortedArray);
+}
+
+const size_t MaxNaturalRuns = 64;
+
+void countAdjacentOrder(const int* data, size_t size, size_t& descents, size_t& ascents) {
+    descents = 0;
+    ascents = 0;
+    size_t i = 0;
+#if defined(TREE_SIMD_AVX2)
+    __m256i descentLanes = _mm256_setzero_si256();
+    __m256i ascentLanes = _mm256_setzero_si256();
+    for (; i + 8 < size; i += 8) {
+        __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+        descentLanes = _mm256_sub_epi32(descentLanes, _mm256_cmpgt_epi32(current, next));
+        ascentLanes = _mm256_sub_epi32(ascentLanes, _mm256_cmpgt_epi32(next, current));
+    }
+    uint32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), descentLanes);
+    for (uint32_t lane : lanes) {
+        descents += lane;
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), ascentLanes);
+    for (uint32_t lane : lanes) {
+        ascents += lane;
+    }
+#elif defined(TREE_SIMD_SSE2)
+    __m128i descentLanes = _mm_setzero_si128();
+    __m128i ascentLanes = _mm_setzero_si128();
+    for (; i + 4 < size; i += 4) {
+        __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+        descentLanes = _mm_sub_epi32(descentLanes, _mm_cmpgt_epi32(current, next));
+        ascentLanes = _mm_sub_epi32(ascentLanes, _mm_cmplt_epi32(current, next));
+    }
+    uint32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), descentLanes);
+    for (uint32_t lane : lanes) {
+        descents += lane;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), ascentLanes);
+    for (uint32_t lane : lanes) {
+        ascents += lane;
+    }
+#endif
+    for (; i + 1 < size; ++i) {
+        descents += data[i] > data[i + 1];
+        ascents += data[i] < data[i + 1];
+    }
+}
+
+// Handles input that is sorted, reversed or made of at most MaxNaturalRuns runs without building a tree.
+// Returns false, leaving sortedArray untouched, when the input needs the tree.
+bool sortNaturalRuns(const std::vector<int>& arr, std::vector<int>& sortedArray) {
+    size_t descents = 0;
+    size_t ascents = 0;
+    countAdjacentOrder(arr.data(), arr.size(), descents, ascents);
+    if (descents == 0) {
+        sortedArray = arr;
+        return true;
+    }
+    if (ascents == 0) {
+        sortedArray.assign(arr.rbegin(), arr.rend());
+        return true;
+    }
+
+    std::vector<size_t> bounds(1, 0);
+    std::vector<bool> descending;
+    size_t start = 0;
+    while (start < arr.size()) {
+        size_t end = start + 1;
+        bool isDescending = end < arr.size() && arr[end] < arr[start];
+        if (isDescending) {
+            while (end < arr.size() && arr[end] < arr[end - 1]) {
+                ++end;
+            }
+        }
+        else {
+            while (end < arr.size() && arr[end] >= arr[end - 1]) {
+                ++end;
+            }
+        }
+        if (bounds.size() > MaxNaturalRuns) {
+            return false;
+        }
+        bounds.push_back(end);
+        descending.push_back(isDescending);
+        start = end;
+    }
+
+    sortedArray.resize(arr.size());
+    for (size_t run = 0; run + 1 < bounds.size(); ++run) {
+        if (descending[run]) {
+            std::reverse_copy(arr.begin() + bounds[run], arr.begin() + bounds[run + 1], sortedArray.begin() + bounds[run]);
+        }
+        else {
+            std::copy(arr.begin() + bounds[run], arr.begin() + bounds[run + 1], sortedArray.begin() + bounds[run]);
+        }
+    }
+    std::vector<int> buffer(arr.size());
+    while (bounds.size() > 2) {
+        std::vector<size_t> mergedBounds(1, 0);
+        for (size_t run = 0; run + 1 < bounds.size(); run += 2) {
+            size_t middle = bounds[run + 1];
+            size_t end = run + 2 < bounds.size() ? bounds[run + 2] : bounds[run + 1];
+            std::merge(sortedArray.begin() + bounds[run], sortedArray.begin() + middle,
+                sortedArray.begin() + middle, sortedArray.begin() + end, buffer.begin() + bounds[run]);
+            mergedBounds.push_back(end);
+        }
+        sortedArray.swap(buffer);
+        bounds.swap(mergedBounds);
+    }
+    return true;
+}
+
+inline unsigned defaultThreadCount() {
+    unsigned threadCount = std::thread::hardware_concurrency();
+    return threadCount == 0 ? 1 : threadCount;
+}
+
+// Runs task(0) .. task(threadCount - 1) concurrently, task(0) on the calling thread.
+template <typename Task>
+void runOnThreads(unsigned threadCount, Task task) {
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned i = 1; i < threadCount; ++i) {
+        threads.emplace_back(task, i);
+    }
+    task(0u);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// Each worker pops tasks from the back of its own deque and steals from the front of the others' once it runs
+// dry, sleeping while nothing is queued. run returns when no task is queued or running; tasks may push more.
+template <typename Task>
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned threadCount) : queues(threadCount), pending(0), queued(0) {}
+
+    void push(unsigned worker, const Task& task) {
+        pending.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+            queued.fetch_add(1);
+        }
+        {
+            std::lock_guard<std::mutex> lock(queues[worker].mutex);
+            queues[worker].tasks.push_back(task);
+        }
+        idle.notify_one();
+    }
+
+    template <typename Run>
+    void run(Run runTask) {
+        runOnThreads(static_cast<unsigned>(queues.size()), [&](unsigned worker) {
+            Task task;
+            while (true) {
+                if (take(worker, task)) {
+                    runTask(worker, task);
+                    if (pending.fetch_sub(1) == 1) {
+                        std::lock_guard<std::mutex> lock(idleMutex);
+                        idle.notify_all();
+                    }
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(idleMutex);
+                idle.wait(lock, [&]() { return queued.load() > 0 || pending.load() == 0; });
+                if (pending.load() == 0) {
+                    return;
+                }
+            }
+        });
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool take(unsigned worker, Task& task) {
+        for (size_t i = 0; i < queues.size(); ++i) {
+            Queue& queue = queues[(worker + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                if (i == 0) {
+                    task = queue.tasks.back();
+                    queue.tasks.pop_back();
+                }
+                else {
+                    task = queue.tasks.front();
+                    queue.tasks.pop_front();
+                }
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Queue> queues;
+    std::atomic<size_t> pending;
+    std::atomic<size_t> queued;
+    std::mutex idleMutex;
+    std::condition_variable idle;
+};
+
+const size_t ParallelCollectGrain = 1 << 14;
+
+// Same output as collectSortedValues(root, out), but a subtree's place in out follows from the subtree sizes,
+// so right subtrees are handed to other workers while the current one descends left. Subtrees smaller than
+// ParallelCollectGrain are written serially. Sizes must be current (see recountSubtreeSizes).
+int* collectSortedValuesParallel(SizedNode* root, int* out, unsigned threadCount) {
+    if (threadCount < 2 || subtreeSize(root) < ParallelCollectGrain) {
+        return collectSortedValues(root, out);
+    }
+    typedef std::pair<SizedNode*, int*> CollectTask;
+    WorkStealingPool<CollectTask> pool(threadCount);
+    pool.push(0, CollectTask(root, out));
+    pool.run([&](unsigned worker, const CollectTask& task) {
+        // Every node on the left spine starts its output where the task does.
+        SizedNode* node = task.first;
+        while (subtreeSize(node) >= ParallelCollectGrain) {
+            int* position = task.second + subtreeSize(node->left);
+            std::fill(position, position + node->count, node->value);
+            if (node->right != nullptr) {
+                pool.push(worker, CollectTask(node->right, position + node->count));
+            }
+            node = node->left;
+        }
+        collectSortedValues(node, task.second);
+    });
+    return out + subtreeSize(root);
+}
+
+const size_t ParallelSortMinSize = 1 << 16;
+const size_t SplitterOversampling = 32;
+
+// Sample sort: up to BTreeKeySlots ranges are split by sampled splitters, the values are partitioned with the
+// same SIMD search the wide nodes use, and each range is finger-inserted into its own tree and arena on its own
+// thread, writing straight into its slice of sortedArray. Splitters come from an oversampled, deduplicated
+// sample; a heavily repeated value lands in a single range, where the tree collapses it into one node.
+void sortParallelSamples(const std::vector<int>& arr, std::vector<int>& sortedArray, unsigned threadCount) {
+    threadCount = std::min<unsigned>(threadCount, BTreeKeySlots);
+    sortedArray.resize(arr.size());
+    if (threadCount < 2 || arr.size() < ParallelSortMinSize) {
+        NodeArena arena;
+        TreeFinger finger;
+        collectSortedValues(buildBinarySortTree(arr, arena, finger), sortedArray.data());
+        return;
+    }
+
+    std::mt19937 generator(static_cast<uint32_t>(arr.size()));
+    std::vector<int> sample(threadCount * SplitterOversampling);
+    for (int& val : sample) {
+        val = arr[generator() % arr.size()];
+    }
+    std::sort(sample.begin(), sample.end());
+    alignas(64) int splitters[BTreeKeySlots];
+    std::fill(splitters, splitters + BTreeKeySlots, INT_MAX);
+    int splitterCount = 0;
+    for (unsigned i = 1; i < threadCount; ++i) {
+        int splitter = sample[i * SplitterOversampling];
+        if (splitterCount == 0 || splitter != splitters[splitterCount - 1]) {
+            splitters[splitterCount++] = splitter;
+        }
+    }
+
+    const size_t rangeCount = splitterCount + 1;
+    const size_t chunkSize = (arr.size() + threadCount - 1) / threadCount;
+    std::vector<uint8_t> ranges(arr.size());
+    std::vector<size_t> offsets(threadCount * rangeCount, 0);
+    runOnThreads(threadCount, [&](unsigned thread) {
+        size_t begin = std::min(thread * chunkSize, arr.size());
+        size_t end = std::min(begin + chunkSize, arr.size());
+        size_t* counts = &offsets[thread * rangeCount];
+        for (size_t i = begin; i < end; ++i) {
+            int range = upperBoundInNode(splitters, splitterCount, arr[i]);
+            ranges[i] = static_cast<uint8_t>(range);
+            ++counts[range];
+        }
+    });
+
+    std::vector<size_t> rangeStart(rangeCount + 1);
+    size_t offset = 0;
+    for (size_t range = 0; range < rangeCount; ++range) {
+        rangeStart[range] = offset;
+        for (unsigned thread = 0; thread < threadCount; ++thread) {
+            size_t count = offsets[thread * rangeCount + range];
+            offsets[thread * rangeCount + range] = offset;
+            offset += count;
+        }
+    }
+    rangeStart[rangeCount] = offset;
+
+    std::vector<int> partitioned(arr.size());
+    runOnThreads(threadCount, [&](unsigned thread) {
+        size_t begin = std::min(thread * chunkSize, arr.size());
+        size_t end = std::min(begin + chunkSize, arr.size());
+        size_t* next = &offsets[thread * rangeCount];
+        for (size_t i = begin; i < end; ++i) {
+            partitioned[next[ranges[i]]++] = arr[i];
+        }
+    });
+
+    runOnThreads(static_cast<unsigned>(rangeCount), [&](unsigned range) {
+        NodeArena arena;
+        TreeFinger finger;
+        Node* root = nullptr;
+        for (size_t i = rangeStart[range]; i < rangeStart[range + 1]; ++i) {
+            insertNode(root, partitioned[i], arena, finger);
+        }
+        collectSortedValues(root, sortedArray.data() + rangeStart[range]);
+    });
+}
+
+// Merges the sorted runs data[bounds[i], bounds[i + 1]) into out with a loser tree: leaves sit at
+// runCount + run, each internal node keeps the loser of its match, and replacing the winner replays one
+// leaf-to-root path.
+void mergeSortedRuns(const int* data, const std::vector<size_t>& bounds, int* out) {
+    const size_t runCount = bounds.size() - 1;
+    std::vector<size_t> position(bounds.begin(), bounds.end() - 1);
+    auto beats = [&](size_t a, size_t b) {
+        if (position[b] == bounds[b + 1]) {
+            return true;
+        }
+        if (position[a] == bounds[a + 1]) {
+            return false;
+        }
+        return data[position[a]] < data[position[b]] || (data[position[a]] == data[position[b]] && a < b);
+    };
+
+    std::vector<size_t> losers(runCount);
+    std::vector<size_t> winners(2 * runCount);
+    for (size_t run = 0; run < runCount; ++run) {
+        winners[runCount + run] = run;
+    }
+    for (size_t node = runCount - 1; node > 0; --node) {
+        size_t left = winners[2 * node];
+        size_t right = winners[2 * node + 1];
+        bool leftWins = beats(left, right);
+        winners[node] = leftWins ? left : right;
+        losers[node] = leftWins ? right : left;
+    }
+
+    size_t winner = winners[1];
+    const size_t total = bounds.back() - bounds.front();
+    for (size_t i = 0; i < total; ++i) {
+        out[i] = data[position[winner]++];
+        for (size_t node = (runCount + winner) / 2; node > 0; node /= 2) {
+            if (beats(losers[node], winner)) {
+                std::swap(losers[node], winner);
+            }
+        }
+    }
+}
+
+// Splits the input into one contiguous chunk per thread, sorts every chunk with its own finger tree and arena,
+// then merges the chunk outputs. Unlike sortParallelSamples it needs no partitioning pass.
+void sortParallelChunks(const std::vector<int>& arr, std::vector<int>& sortedArray, unsigned threadCount) {
+    sortedArray.resize(arr.size());
+    if (threadCount < 2 || arr.size() < ParallelSortMinSize) {
+        NodeArena arena;
+        TreeFinger finger;
+        collectSortedValues(buildBinarySortTree(arr, arena, finger), sortedArray.data());
+        return;
+    }
+
+    std::vector<size_t> bounds(threadCount + 1);
+    for (unsigned thread = 0; thread <= threadCount; ++thread) {
+        bounds[thread] = arr.size() * thread / threadCount;
+    }
+    std::vector<int> runs(arr.size());
+    runOnThreads(threadCount, [&](unsigned thread) {
+        NodeArena arena;
+        TreeFinger finger;
+        Node* root = nullptr;
+        for (size_t i = bounds[thread]; i < bounds[thread + 1]; ++i) {
+            insertNode(root, arr[i], arena, finger);
+        }
+        collectSortedValues(root, runs.data() + bounds[thread]);
+    });
+    mergeSortedRuns(runs.data(), bounds, sortedArray.data());
+}
+
+std::vector<int> sortWithEngine(const std::vector<int>& arr, int mode, uint32_t seed) {
+    std::vector<int> sortedArray;
+    sortedArray.reserve(arr.size());
+    if (mode == SortModes::Compact) {
+        sortWithTree<CompactTree>(arr, sortedArray);
+    }
+    else if (mode == SortModes::RedBlack) {
+        sortWithTree<BalancedTree<RedBlackPolicy>>(arr, sortedArray);
+    }
+    else if (mode == SortModes::Avl) {
+        sortWithTree<BalancedTree<AvlPolicy>>(arr, sortedArray);
+    }
+    else if (mode == SortModes::Scapegoat) {
+        sortWithTree<BalancedTree<ScapegoatPolicy>>(arr, sortedArray);
+    }
+    else if (mode == SortModes::Treap) {
+        BalancedTree<TreapPolicy> tree;
+        tree.policy.seed = seed;
+        buildBinarySortTree(arr, tree);
+        collectSortedValues(tree, sortedArray);
+    }
+    else if (mode == SortModes::WideNode) {
+        sortWithTree<BTree>(arr, sortedArray);
+    }
+    else if (mode == SortModes::Finger) {
+        NodeArena arena;
+        TreeFinger finger;
+        Node* root = buildBinarySortTree(arr, arena, finger);
+        sortedArray.resize(arr.size());
+        collectSortedValues(root, sortedArray.data());
+    }
+    else if (mode == SortModes::ParallelSample) {
+        sortParallelSamples(arr, sortedArray, defaultThreadCount());
+    }
+    else if (mode == SortModes::ParallelMerge) {
+        sortParallelChunks(arr, sortedArray, defaultThreadCount());
+    }
+    else if (mode == SortModes::ParallelCollect) {
+        // Every insertion descends from the root, so the subtree sizes are current when the collect starts.
+        SizedNodeArena arena;
+        SizedNode* root = buildBinarySortTree(arr, arena);
+        sortedArray.resize(arr.size());
+        collectSortedValuesParallel(root, sortedArray.data(), defaultThreadCount());
+    }
+    else {
+        NodeArena arena;
+        Node* root = buildBinarySortTree(arr, arena);
+        sortedArray.resize(arr.size());
+        collectSortedValues(root, sortedArray.data());
+    }
+    return sortedArray;
+}
+
+std::vector<int> binaryTreeSort(const std::vector<int>& arr, int mode = SortModes::Basic, uint32_t seed = DefaultTreapSeed) {
+    std::vector<int> sortedArray;
+    if (sortNaturalRuns(arr, sortedArray)) {
+        return sortedArray;
+    }
+    return sortWithEngine(arr, mode, seed);
+}
+
+// Maps a value to the key the tree compares. Floating-point values become unsigned integers whose order
+// matches the numeric order (negative values have all bits flipped, the rest get the sign bit set).
+template <typename T>
+struct SortKey {
+    const T& operator()(const T& value) const {
+        return value;
+    }
+};
+
+template <>
+struct SortKey<float> {
+    uint32_t operator()(float value) const {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (bits & 0x80000000u) != 0 ? ~bits : bits | 0x80000000u;
+    }
+};
+
+template <>
+struct SortKey<double> {
+    uint64_t operator()(double value) const {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (bits & 0x8000000000000000ull) != 0 ? ~bits : bits | 0x8000000000000000ull;
+    }
+};
+
+// Sorts any element type through a red-black tree of extracted keys. Compare and KeyFn are template
+// parameters, so a descending or custom order is inlined into the descent like the default one.
+template <typename T, typename Compare = std::less<>, typename KeyFn = SortKey<T>,
+    typename Key = typename std::decay<decltype(std::declval<KeyFn&>()(std::declval<const T&>()))>::type>
+std::vector<T> binaryTreeSort(const std::vector<T>& arr, Compare compare = Compare(), KeyFn keyFn = KeyFn()) {
+    BalancedTree<RedBlackPolicy, Key, Compare> tree;
+    tree.compare = compare;
+    tree.nodes.reserve(arr.size());
+    for (const T& value : arr) {
+        insertNode(tree, keyFn(value));
+    }
+    std::vector<T> sortedArray;
+    sortedArray.reserve(arr.size());
+    tree.forEachInOrder(tree.root, [&](uint32_t index) { sortedArray.push_back(arr[index]); });
+    return sortedArray;
+}
+
+// Keeps the k first values under Compare in a treap of at most k nodes. Once full, a value that does not
+// beat the current last one is rejected in O(1); otherwise the last node, which has no right child, is
+// spliced out (that keeps the heap order) and its slot is reused for the new value.
+template <typename Compare>
+std::vector<int> collectBoundedValues(const std::vector<int>& arr, size_t k, uint32_t seed) {
+    if (k == 0) {
+        return std::vector<int>();
+    }
+    BalancedTree<TreapPolicy, int, Compare> tree;
+    tree.policy.seed = seed;
+    tree.nodes.reserve(std::min(k, arr.size()));
+    uint32_t insertions = 0;
+    uint32_t last = NullIndex;
+    for (int val : arr) {
+        if (tree.nodes.size() < k) {
+            insertNode(tree, val);
+        }
+        else if (tree.compare(val, tree.nodes[last].value)) {
+            uint32_t* link = &tree.root;
+            while (tree.nodes[*link].child[1] != NullIndex) {
+                link = &tree.nodes[*link].child[1];
+            }
+            *link = tree.nodes[last].child[0];
+            tree.nodes[last] = { val, { NullIndex, NullIndex }, tree.policy.newNodeData(insertions) };
+            attachNode(tree, last);
+        }
+        else {
+            continue;
+        }
+        ++insertions;
+        last = tree.root;
+        while (tree.nodes[last].child[1] != NullIndex) {
+            last = tree.nodes[last].child[1];
+        }
+    }
+    std::vector<int> sortedArray;
+    sortedArray.reserve(tree.nodes.size());
+    collectSortedValues(tree, sortedArray);
+    return sortedArray;
+}
+
+// Returns the k smallest (or largest) values in ascending order using O(k) memory and O(n log k) time.
+std::vector<int> binaryTreeSortBounded(const std::vector<int>& arr, size_t k, bool largest = false, uint32_t seed = DefaultTreapSeed) {
+    if (!largest) {
+        return collectBoundedValues<std::less<int>>(arr, k, seed);
+    }
+    std::vector<int> sortedArray = collectBoundedValues<std::greater<int>>(arr, k, seed);
+    std::reverse(sortedArray.begin(), sortedArray.end());
+    return sortedArray;
+}
+
+// Keeps the last `window` samples of a stream in a counted AVL tree. Each push erases the oldest sample and
+// inserts the new one, and each query is a select, so both cost O(log window).
+class SlidingWindow {
+public:
+    explicit SlidingWindow(size_t window) : window(std::max<size_t>(window, 1)) {}
+
+    void push(int sample) {
+        if (samples.size() == window) {
+            eraseNode(tree, samples.front());
+            samples.pop_front();
+        }
+        insertNode(tree, sample);
+        samples.push_back(sample);
+    }
+
+    size_t size() const {
+        return samples.size();
+    }
+
+    // Same conventions as SortTree: k is 0-based and percentiles use the nearest rank.
+    int select(size_t k) const {
+        if (k >= samples.size()) {
+            throw std::out_of_range("SlidingWindow::select index out of range");
+        }
+        return selectValue(tree, k);
+    }
+
+    int median() const {
+        return select(samples.empty() ? 0 : (samples.size() - 1) / 2);
+    }
+
+    int percentile(double percent) const {
+        return select(nearestRankIndex(percent, samples.size()));
+    }
+
+private:
+    size_t window;
+    std::deque<int> samples;
+    BalancedTree<AvlPolicy, int, std::less<int>, true> tree;
+};
+
+// Returns the given percentile of the last `window` samples after each sample of the stream.
+std::vector<int> slidingWindowPercentiles(const std::vector<int>& stream, size_t window, double percent = 50) {
+    SlidingWindow slidingWindow(window);
+    std::vector<int> result;
+    result.reserve(stream.size());
+    for (int sample : stream) {
+        slidingWindow.push(sample);
+        result.push_back(slidingWindow.percentile(percent));
+    }
+    return result;
+}
+
+// Returns the input positions of keys in stable sorted order.
+template <typename Key, typename Compare = std::less<>>
+std::vector<uint32_t> binaryTreeSortOrder(const std::vector<Key>& keys, Compare compare = Compare()) {
+    BalancedTree<RedBlackPolicy, Key, Compare> tree;
+    tree.compare = compare;
+    buildBinarySortTree(keys, tree);
+    std::vector<uint32_t> order;
+    order.reserve(keys.size());
+    tree.forEachInOrder(tree.root, [&](uint32_t index) { order.push_back(index); });
+    return order;
+}
+
+// Stable sort of (keys[i], payloads[i]) records. Only the keys go into the tree; a node's index is the
+// record's position, so each payload is moved exactly once while the result is gathered.
+template <typename Key, typename Payload, typename Compare = std::less<>>
+void binaryTreeSortRecords(std::vector<Key>& keys, std::vector<Payload>& payloads, Compare compare = Compare()) {
+    if (keys.size() != payloads.size()) {
+        std::cerr << "Record sort needs one payload per key: " << keys.size() << " keys, " << payloads.size() << " payloads" << std::endl;
+        return;
+    }
+    BalancedTree<RedBlackPolicy, Key, Compare> tree;
+    tree.compare = compare;
+    buildBinarySortTree(keys, tree);
+    std::vector<Key> sortedKeys;
+    std::vector<Payload> sortedPayloads;
+    sortedKeys.reserve(keys.size());
+    sortedPayloads.reserve(payloads.size());
+    tree.forEachInOrder(tree.root, [&](uint32_t index) {
+        sortedKeys.push_back(tree.nodes[index].value);
+        sortedPayloads.push_back(std::move(payloads[index]));
+    });
+    keys.swap(sortedKeys);
+    payloads.swap(sortedPayloads);
+}
+
+// Read-only view of a whole file through a Win32 file mapping. An empty file is open with size 0.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) : file(INVALID_HANDLE_VALUE), mapping(NULL), view(nullptr), length(0), opened(false) {
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        LARGE_INTEGER fileSize;
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+            return;
+        }
+        if (fileSize.QuadPart == 0) {
+            opened = true;
+            return;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL) {
+            view = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (view != nullptr) {
+            length = static_cast<size_t>(fileSize.QuadPart);
+            opened = true;
+        }
+    }
+
+    ~MappedFile() {
+        if (view != nullptr) {
+            UnmapViewOfFile(view);
+        }
+        if (mapping != NULL) {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const {
+        return opened;
+    }
+
+    const char* data() const {
+        return view;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+private:
+    HANDLE file;
+    HANDLE mapping;
+    const char* view;
+    size_t length;
+    bool opened;
+};
+
+namespace ElementTypes {
+    const uint8_t Int32 = 1;
+    const uint8_t Int64 = 2;
+    const uint8_t Float32 = 3;
+    const uint8_t Float64 = 4;
+}
+
+const char BinaryMagic[4] = { 'B', 'T', 'S', 'N' };
+const uint16_t BinaryVersion = 1;
+
+// Binary numbers file: this header, then count raw values of elementType. Everything is stored in host byte
+// order, which is little-endian on every Windows target. The checksum covers the values only.
+struct BinaryHeader {
+    char magic[4];
+    uint16_t version;
+    uint8_t elementType;
+    uint8_t sorted;
+    uint64_t count;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(BinaryHeader) == 24, "BinaryHeader must have no padding");
+
+template <typename T>
+constexpr uint8_t binaryElementType() {
+    static_assert((std::is_integral<T>::value && std::is_signed<T>::value) || std::is_floating_point<T>::value, "unsupported element type");
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "unsupported element size");
+    if (std::is_floating_point<T>::value) {
+        return sizeof(T) == 4 ? ElementTypes::Float32 : ElementTypes::Float64;
+    }
+    return sizeof(T) == 4 ? ElementTypes::Int32 : ElementTypes::Int64;
+}
+
+inline size_t binaryElementSize(uint8_t elementType) {
+    if (elementType == ElementTypes::Int32 || elementType == ElementTypes::Float32) {
+        return 4;
+    }
+    if (elementType == ElementTypes::Int64 || elementType == ElementTypes::Float64) {
+        return 8;
+    }
+    return 0;
+}
+
+// FNV-1a over 64-bit words; every step is a bijection of the running hash, so a single changed word always
+// changes the result.
+uint64_t binaryChecksum(const char* data, size_t size) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 0x100000001B3ull;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+inline bool isBinaryNumbersFile(const MappedFile& file) {
+    return file.size() >= sizeof(BinaryHeader) && std::memcmp(file.data(), BinaryMagic, sizeof(BinaryMagic)) == 0;
+}
+
+// Reads and checks the header of a file that isBinaryNumbersFile accepted, reporting problems to cerr.
+// The checksum pass touches every page, so callers that only want the mapping can skip it.
+bool readBinaryHeader(const std::string& path, const MappedFile& file, BinaryHeader& header, bool verifyChecksum) {
+    std::memcpy(&header, file.data(), sizeof(header));
+    size_t elementSize = binaryElementSize(header.elementType);
+    if (header.version != BinaryVersion || elementSize == 0) {
+        std::cerr << "Unsupported binary numbers file " << path << std::endl;
+        return false;
+    }
+    size_t payloadSize = file.size() - sizeof(header);
+    if (header.count != payloadSize / elementSize || payloadSize % elementSize != 0) {
+        std::cerr << "Truncated binary numbers file " << path << ": header says " << header.count << " values" << std::endl;
+        return false;
+    }
+    if (verifyChecksum && binaryChecksum(file.data() + sizeof(header), payloadSize) != header.checksum) {
+        std::cerr << "Checksum mismatch in " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// A binary numbers file opened in place: the values are read straight from the mapping, so opening a sorted
+// dataset costs no parsing or copying. The element type must match T.
+template <typename T>
+class MappedNumbers {
+public:
+    explicit MappedNumbers(const std::string& path, bool verifyChecksum = false) : file(path), header(), valid(false) {
+        if (!file.isOpen() || !isBinaryNumbersFile(file)) {
+            std::cerr << "Not a binary numbers file: " << path << std::endl;
+            return;
+        }
+        if (!readBinaryHeader(path, file, header, verifyChecksum)) {
+            return;
+        }
+        if (header.elementType != binaryElementType<T>()) {
+            std::cerr << "Element type of " << path << " does not match the requested type" << std::endl;
+            return;
+        }
+        valid = true;
+    }
+
+    bool isValid() const {
+        return valid;
+    }
+
+    bool isSorted() const {
+        return valid && header.sorted != 0;
+    }
+
+    size_t size() const {
+        return valid ? static_cast<size_t>(header.count) : 0;
+    }
+
+    const T* begin() const {
+        return reinterpret_cast<const T*>(file.data() + sizeof(BinaryHeader));
+    }
+
+    const T* end() const {
+        return begin() + size();
+    }
+
+    const T& operator[](size_t index) const {
+        return begin()[index];
+    }
+
+private:
+    MappedFile file;
+    BinaryHeader header;
+    bool valid;
+};
+
+inline bool hasBinaryExtension(const std::string& path) {
+    return path.size() >= 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+}
+
+// Malformed tokens are counted and the first few kept, cut to MaxSampleBytes, so a bad file costs one short
+// diagnostic line even when it has no separators and the whole file is one token.
+struct ParseErrors {
+    static const size_t MaxSamples = 5;
+    static const size_t MaxSampleBytes = 32;
+
+    explicit ParseErrors(const char* origin) : origin(origin) {}
+
+    void add(const char* begin, const char* end) {
+        if (samples.size() < MaxSamples) {
+            if (static_cast<size_t>(end - begin) > MaxSampleBytes) {
+                samples.emplace_back(static_cast<size_t>(begin - origin), std::string(begin, MaxSampleBytes) + "...");
+            }
+            else {
+                samples.emplace_back(static_cast<size_t>(begin - origin), std::string(begin, end));
+            }
+        }
+        ++count;
+    }
+
+    void add(const char* at, const std::string& token) {
+        if (samples.size() < MaxSamples) {
+            samples.emplace_back(static_cast<size_t>(at - origin), token);
+        }
+        ++count;
+    }
+
+    const char* origin;
+    size_t count = 0;
+    std::vector<std::pair<size_t, std::string>> samples;
+};
+
+void reportParseErrors(const std::string& path, const ParseErrors& errors) {
+    if (errors.count == 0) {
+        return;
+    }
+    std::cerr << "Skipped " << errors.count << " malformed or out of range numbers in " << path << ":";
+    for (size_t i = 0; i < errors.samples.size(); ++i) {
+        std::cerr << (i == 0 ? " \"" : ", \"") << errors.samples[i].second << "\" at byte " << errors.samples[i].first;
+    }
+    if (errors.count > errors.samples.size()) {
+        std::cerr << ", ...";
+    }
+    std::cerr << std::endl;
+}
+
+// Whether value converts to T exactly enough to keep, by the rules the text parser applies: integers must fit,
+// floating values read as integers must be whole and in range, and doubles read as floats must not overflow.
+template <typename T, typename Source>
+bool fitsBinaryElement(Source value) {
+    if constexpr (std::is_integral<T>::value && std::is_floating_point<Source>::value) {
+        const Source limit = std::ldexp(Source(1), std::numeric_limits<T>::digits);
+        return value >= -limit && value < limit && value == std::trunc(value);
+    }
+    else if constexpr (std::is_integral<T>::value && sizeof(Source) > sizeof(T)) {
+        return value >= std::numeric_limits<T>::min() && value <= std::numeric_limits<T>::max();
+    }
+    else if constexpr (std::is_floating_point<T>::value && std::is_floating_point<Source>::value && sizeof(Source) > sizeof(T)) {
+        return !(std::fabs(value) > std::numeric_limits<T>::max()) || std::isinf(value);
+    }
+    else {
+        return true;
+    }
+}
+
+template <typename Source, typename T, typename Consume>
+void forEachBinaryElement(const char* payload, size_t count, ParseErrors& errors, Consume& consume) {
+    for (size_t i = 0; i < count; ++i) {
+        const char* element = payload + i * sizeof(Source);
+        Source value;
+        std::memcpy(&value, element, sizeof(Source));
+        if (fitsBinaryElement<T>(value)) {
+            consume(static_cast<T>(value));
+        }
+        else {
+            char text[32];
+            errors.add(element, std::string(text, std::to_chars(text, text + sizeof(text), value).ptr));
+        }
+    }
+}
+
+// Calls consume(value) for every value of a checked binary file, converted to T. Values T cannot hold are
+// skipped and recorded in errors at their byte offset, like malformed text tokens.
+template <typename T, typename Consume>
+void forEachBinaryValue(const MappedFile& file, const BinaryHeader& header, ParseErrors& errors, Consume consume) {
+    const char* payload = file.data() + sizeof(BinaryHeader);
+    size_t count = static_cast<size_t>(header.count);
+    if (header.elementType == ElementTypes::Int32) {
+        forEachBinaryElement<int32_t, T>(payload, count, errors, consume);
+    }
+    else if (header.elementType == ElementTypes::Int64) {
+        forEachBinaryElement<int64_t, T>(payload, count, errors, consume);
+    }
+    else if (header.elementType == ElementTypes::Float32) {
+        forEachBinaryElement<float, T>(payload, count, errors, consume);
+    }
+    else {
+        forEachBinaryElement<double, T>(payload, count, errors, consume);
+    }
+}
+
+inline bool isSeparator(char c) {
+    return c == ',' || c == '\n';
+}
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Returns 64 for an empty mask.
+inline int countTrailingZeros(uint64_t mask) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    return _BitScanForward64(&index, mask) ? static_cast<int>(index) : 64;
+#elif defined(__GNUC__)
+    return mask == 0 ? 64 : __builtin_ctzll(mask);
+#else
+    uint64_t below = (mask & (~mask + 1)) - 1;
+    return countBits(static_cast<uint32_t>(below)) + countBits(static_cast<uint32_t>(below >> 32));
+#endif
+}
+
+// Eight digit values, the most significant in the lowest byte, combined pairwise in three multiplies.
+inline uint32_t combineEightDigits(uint64_t digits) {
+    digits = digits * 10 + (digits >> 8);
+    digits = (((digits & 0x000000FF000000FFull) * (100 + (1000000ull << 32)))
+        + (((digits >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+    return static_cast<uint32_t>(digits);
+}
+
+// Reads up to eight digits at p with one 8-byte load where the buffer allows it. Returns how many were read.
+inline int readDigitChunk(const char* p, const char* end, uint32_t& chunkValue) {
+    if (end - p >= 8) {
+        uint64_t chunk;
+        std::memcpy(&chunk, p, 8);
+        uint64_t digits = chunk - 0x3030303030303030ull;
+        uint64_t nonDigits = (digits | (digits + 0x7676767676767676ull)) & 0x8080808080808080ull;
+        int count = countTrailingZeros(nonDigits) / 8;
+        if (count > 0) {
+            chunkValue = combineEightDigits(count == 8 ? digits : digits << (8 * (8 - count)));
+        }
+        return count;
+    }
+    int count = 0;
+    chunkValue = 0;
+    while (count < 8 && p + count != end && static_cast<unsigned char>(p[count] - '0') < 10) {
+        chunkValue = chunkValue * 10 + (p[count] - '0');
+        ++count;
+    }
+    return count;
+}
+
+const uint64_t PowersOfTen[9] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+template <typename T>
+bool parseValue(const char*& p, const char* end, T& result) {
+    bool negative = *p == '-';
+    p += negative || *p == '+';
+    if constexpr (std::is_integral<T>::value) {
+        const char* digitsBegin = p;
+        while (p != end && *p == '0') {
+            ++p;
+        }
+        uint64_t magnitude = 0;
+        int digits = 0;
+        bool overflow = false;
+        while (true) {
+            uint32_t chunkValue;
+            int count = readDigitChunk(p, end, chunkValue);
+            p += count;
+            if (digits + count > 19) {
+                overflow = true;
+            }
+            else if (count > 0) {
+                magnitude = magnitude * PowersOfTen[count] + chunkValue;
+            }
+            digits += count;
+            if (count < 8) {
+                break;
+            }
+        }
+        uint64_t limit = static_cast<uint64_t>(std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+        if (p == digitsBegin || overflow || magnitude > limit || (negative && std::is_unsigned<T>::value && magnitude != 0)) {
+            return false;
+        }
+        result = negative ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+        return true;
+    }
+    else {
+        if (p == end || *p == '-') {
+            return false;
+        }
+        std::from_chars_result parsed = std::from_chars(p, end, result);
+        if (parsed.ec != std::errc()) {
+            return false;
+        }
+        p = parsed.ptr;
+        result = negative ? -result : result;
+        return true;
+    }
+}
+
+// Bit i is set when p[i] is a comma or newline. p must have 64 readable bytes.
+inline uint64_t separatorMask(const char* p) {
+    uint64_t mask = 0;
+#if defined(TREE_SIMD_AVX2)
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (int i = 0; i < 64; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(block, comma), _mm256_cmpeq_epi8(block, newline));
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(hits))) << i;
+    }
+#elif defined(TREE_SIMD_SSE2)
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (int i = 0; i < 64; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(block, comma), _mm_cmpeq_epi8(block, newline));
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(hits))) << i;
+    }
+#else
+    for (int i = 0; i < 64; ++i) {
+        mask |= static_cast<uint64_t>(isSeparator(p[i])) << i;
+    }
+#endif
+    return mask;
+}
+
+// Parses a whole token with no blanks around it. Up to eight digits with eight readable bytes before
+// bufferEnd take the branch-light SWAR path; anything else goes through parseValue.
+template <typename T>
+inline bool parseToken(const char* begin, const char* end, const char* bufferEnd, T& result) {
+    if (begin == end) {
+        return false;
+    }
+    if constexpr (std::is_integral<T>::value) {
+        bool negative = *begin == '-';
+        const char* digitsBegin = begin + (negative || *begin == '+');
+        size_t count = end - digitsBegin;
+        if (count - 1 < 8 && bufferEnd - digitsBegin >= 8) {
+            uint64_t chunk;
+            std::memcpy(&chunk, digitsBegin, 8);
+            uint64_t digits = chunk - 0x3030303030303030ull;
+            uint64_t nonDigits = (digits | (digits + 0x7676767676767676ull)) & 0x8080808080808080ull;
+            uint64_t tokenBytes = count == 8 ? ~0ull : (1ull << (8 * count)) - 1;
+            if ((nonDigits & tokenBytes) == 0 && !(negative && std::is_unsigned<T>::value)) {
+                uint32_t magnitude = combineEightDigits(count == 8 ? digits : digits << (8 * (8 - count)));
+                result = negative ? static_cast<T>(0 - static_cast<T>(magnitude)) : static_cast<T>(magnitude);
+                return true;
+            }
+        }
+    }
+    const char* p = begin;
+    return parseValue(p, end, result) && p == end;
+}
+
+// Calls consume(value) for every number in [begin, end) in order. Numbers are separated by commas or newlines
+// and may be padded with blanks; empty tokens are skipped and malformed ones go to errors. Separators are found
+// 64 bytes at a time, so a token's bounds never wait on parsing the token before it.
+template <typename T, typename Consume>
+void forEachNumber(const char* begin, const char* end, ParseErrors& errors, Consume consume) {
+    auto finishToken = [&](const char* tokenBegin, const char* tokenEnd) {
+        T value;
+        if (parseToken(tokenBegin, tokenEnd, end, value)) {
+            consume(value);
+            return;
+        }
+        while (tokenBegin != tokenEnd && isBlank(*tokenBegin)) {
+            ++tokenBegin;
+        }
+        while (tokenEnd != tokenBegin && isBlank(tokenEnd[-1])) {
+            --tokenEnd;
+        }
+        if (tokenBegin == tokenEnd) {
+            return;
+        }
+        if (parseToken(tokenBegin, tokenEnd, end, value)) {
+            consume(value);
+        }
+        else {
+            errors.add(tokenBegin, tokenEnd);
+        }
+    };
+
+    const char* tokenBegin = begin;
+    const char* block = begin;
+    for (; end - block >= 64; block += 64) {
+        for (uint64_t mask = separatorMask(block); mask != 0; mask &= mask - 1) {
+            const char* separator = block + countTrailingZeros(mask);
+            finishToken(tokenBegin, separator);
+            tokenBegin = separator + 1;
+        }
+    }
+    for (; block != end; ++block) {
+        if (isSeparator(*block)) {
+            finishToken(tokenBegin, block);
+            tokenBegin = block + 1;
+        }
+    }
+    finishToken(tokenBegin, end);
+}
+
+const size_t ParallelParseMinBytes = 1 << 20;
+
+// Appends the numbers in the file to numbers. Files of ParallelParseMinBytes or more are cut into one byte range
+// per thread; each range start moves past the next separator so no token is split, every thread parses its
+// range into its own buffer, and the buffers are copied into place concurrently at prefix-sum offsets.
+template <typename T>
+void parseNumbersFromFile(const std::string& path, std::vector<T>& numbers, unsigned threadCount = defaultThreadCount()) {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        std::cerr << "Could not open the file " << path << std::endl;
+        return;
+    }
+    if (isBinaryNumbersFile(file)) {
+        BinaryHeader header;
+        if (!readBinaryHeader(path, file, header, true)) {
+            return;
+        }
+        size_t first = numbers.size();
+        if (header.count == 0) {
+            return;
+        }
+        if (header.elementType == binaryElementType<T>()) {
+            numbers.resize(first + static_cast<size_t>(header.count));
+            std::memcpy(numbers.data() + first, file.data() + sizeof(BinaryHeader), static_cast<size_t>(header.count) * sizeof(T));
+        }
+        else {
+            numbers.reserve(first + static_cast<size_t>(header.count));
+            ParseErrors errors(file.data());
+            forEachBinaryValue<T>(file, header, errors, [&](T value) { numbers.push_back(value); });
+            reportParseErrors(path, errors);
+        }
+        return;
+    }
+    const char* data = file.data();
+    if (threadCount < 2 || file.size() < ParallelParseMinBytes) {
+        ParseErrors errors(data);
+        forEachNumber<T>(data, data + file.size(), errors, [&](T value) { numbers.push_back(value); });
+        reportParseErrors(path, errors);
+        return;
+    }
+
+    std::vector<const char*> bounds(threadCount + 1, data + file.size());
+    bounds[0] = data;
+    for (unsigned thread = 1; thread < threadCount; ++thread) {
+        const char* start = std::max(data + file.size() * thread / threadCount, bounds[thread - 1]);
+        while (start != data + file.size() && !isSeparator(start[-1])) {
+            ++start;
+        }
+        bounds[thread] = start;
+    }
+    std::vector<std::vector<T>> parts(threadCount);
+    std::vector<ParseErrors> errors(threadCount, ParseErrors(data));
+    runOnThreads(threadCount, [&](unsigned thread) {
+        parts[thread].reserve((bounds[thread + 1] - bounds[thread]) / 4);
+        forEachNumber<T>(bounds[thread], bounds[thread + 1], errors[thread], [&](T value) { parts[thread].push_back(value); });
+    });
+
+    std::vector<size_t> offsets(threadCount + 1, numbers.size());
+    for (unsigned thread = 0; thread < threadCount; ++thread) {
+        offsets[thread + 1] = offsets[thread] + parts[thread].size();
+    }
+    numbers.resize(offsets[threadCount]);
+    runOnThreads(threadCount, [&](unsigned thread) {
+        std::copy(parts[thread].begin(), parts[thread].end(), numbers.begin() + offsets[thread]);
+    });
+
+    ParseErrors merged(data);
+    for (const ParseErrors& part : errors) {
+        merged.count += part.count;
+        for (size_t i = 0; i < part.samples.size() && merged.samples.size() < ParseErrors::MaxSamples; ++i) {
+            merged.samples.push_back(part.samples[i]);
+        }
+    }
+    reportParseErrors(path, merged);
+}
+
+// Parses the file and finger-inserts every value into the tree as soon as it is read, so the unsorted input is
+// never held in a vector; only the tree and the result are. Mapped pages fault in while the tree is already
+// being built, and finger insertion keeps sorted or reversed files cheap without a run-detection pass.
+// Binary files are read the same way, and one flagged as sorted int32 data is copied out without a tree.
+std::vector<int> binaryTreeSortFile(const std::string& path) {
+    std::vector<int> sortedArray;
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        std::cerr << "Could not open the file " << path << std::endl;
+        return sortedArray;
+    }
+    NodeArena arena;
+    TreeFinger finger;
+    Node* root = nullptr;
+    size_t count = 0;
+    auto insert = [&](int value) {
+        insertNode(root, value, arena, finger);
+        ++count;
+    };
+    if (isBinaryNumbersFile(file)) {
+        BinaryHeader header;
+        if (!readBinaryHeader(path, file, header, true)) {
+            return sortedArray;
+        }
+        if (header.count == 0) {
+            return sortedArray;
+        }
+        if (header.sorted != 0 && header.elementType == binaryElementType<int>()) {
+            sortedArray.resize(static_cast<size_t>(header.count));
+            std::memcpy(sortedArray.data(), file.data() + sizeof(BinaryHeader), sortedArray.size() * sizeof(int));
+            return sortedArray;
+        }
+        ParseErrors errors(file.data());
+        forEachBinaryValue<int>(file, header, errors, insert);
+        reportParseErrors(path, errors);
+    }
+    else {
+        ParseErrors errors(file.data());
+        forEachNumber<int>(file.data(), file.data() + file.size(), errors, insert);
+        reportParseErrors(path, errors);
+    }
+    sortedArray.resize(count);
+    collectSortedValues(root, sortedArray.data());
+    return sortedArray;
+}
+
+void generateNumbersFile(const std::string& path, int numElements) {
+    std::ofstream outFile(path);
+    if (!outFile) {
+        std::cerr << "Error opening file: " << path << std::endl;
+        return;
+    }
+
+    srand(time(NULL));
+
+    for (int i = 0; i < numElements; ++i) {
+        int number = (rand() % 10000) * 10 + (rand() % 10);
+        if (rand() % 2 == 0) {
+            number *= -1;
+        }
+        outFile << number;
+        if (i < numElements - 1) {
+            outFile << ",";
+        }
+    }
+
+    outFile.close();
+}
+
+const size_t ParallelWriteMinValues = 1 << 16;
 
-        knob.setSize(sf::Vector2f(height, height));
-        knob.setOrigin(knob.getSize().x / 2, knob.getSize().y / 2);
-        knob.setPosition(x, y + height / 2);
-        knob.setFillColor(sf::Color(100, 100, 100));
+template <typename T>
+constexpr size_t maxFormattedChars() {
+    return std::is_integral<T>::value ? std::numeric_limits<T>::digits10 + 3 : 32;
+}
 
-        valueText.setFont(font);
-        valueText.setCharacterSize(24);
-        valueText.setFillColor(sf::Color::Black);
-        valueText.setPosition(x, y - 30);
-        updateValueText();
+// Formats values as comma-separated text into [out, outEnd), which must have room for it (see formattedLength),
+// and returns the end. leadingComma puts a comma before the first value too.
+template <typename T>
+char* formatNumbers(const T* first, const T* last, bool leadingComma, char* out, char* outEnd) {
+    for (const T* value = first; value != last; ++value) {
+        if (leadingComma || value != first) {
+            *out++ = ',';
+        }
+        out = std::to_chars(out, outEnd, *value).ptr;
     }
+    return out;
+}
 
-    void handleEvent(const sf::Event& event) {
-        if (event.type == sf::Event::MouseButtonPressed) {
-            sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
-            if (knob.getGlobalBounds().contains(mousePos)) {
-                isDragging = true;
+// Length of the text formatNumbers writes for values, without a leading comma. Integers are measured by
+// counting digits; floating values have no cheaper exact measure than formatting them into a scratch buffer.
+template <typename T>
+unsigned long long formattedLength(const T* first, const T* last) {
+    unsigned long long length = first == last ? 0 : last - first - 1;
+    for (const T* value = first; value != last; ++value) {
+        if constexpr (std::is_integral<T>::value) {
+            typedef typename std::make_unsigned<T>::type Magnitude;
+            Magnitude magnitude = static_cast<Magnitude>(*value);
+            if (*value < 0) {
+                magnitude = static_cast<Magnitude>(0 - magnitude);
+                ++length;
             }
+            do {
+                ++length;
+                magnitude /= 10;
+            } while (magnitude != 0);
         }
-        else if (event.type == sf::Event::MouseButtonReleased) {
-            isDragging = false;
-        }
-        else if (event.type == sf::Event::MouseMoved) {
-            if (isDragging) {
-                float newX = static_cast<float>(event.mouseMove.x);
-                newX = std::max(track.getPosition().x, std::min(newX, track.getPosition().x + track.getSize().x));
-                knob.setPosition(newX, knob.getPosition().y);
-                currentValue = static_cast<int>(minValue + (maxValue - minValue) * ((newX - track.getPosition().x) / track.getSize().x));
-                updateValueText();
-            }
+        else {
+            char scratch[maxFormattedChars<T>()];
+            length += std::to_chars(scratch, scratch + sizeof(scratch), *value).ptr - scratch;
         }
     }
+    return length;
+}
 
-    void draw(sf::RenderWindow& window) const {
-        window.draw(track);
-        window.draw(knob);
-        window.draw(valueText);
+// Positional WriteFile calls, looping until everything is written.
+bool writeAt(HANDLE file, const char* data, size_t size, unsigned long long offset) {
+    while (size > 0) {
+        DWORD piece = static_cast<DWORD>(std::min<size_t>(size, 1 << 30));
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD written = 0;
+        if (!WriteFile(file, data, piece, &written, &overlapped) || written == 0) {
+            return false;
+        }
+        data += written;
+        size -= written;
+        offset += written;
     }
+    return true;
+}
 
-    int getValue() const {
-        return currentValue;
+// Writes data in the binary format, marking it sorted when it is in ascending order.
+template <typename T>
+void writeNumbersToBinaryFile(const std::string& path, const std::vector<T>& data) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Could not open the file for writing: " << path << std::endl;
+        return;
     }
-
-    void setValue(int value) {
-        currentValue = std::max(minValue, std::min(maxValue, value));
-        float newX = track.getPosition().x + track.getSize().x * ((currentValue - minValue) / static_cast<float>(maxValue - minValue));
-        knob.setPosition(newX, knob.getPosition().y);
-        updateValueText();
+    const char* payload = reinterpret_cast<const char*>(data.data());
+    size_t payloadSize = data.size() * sizeof(T);
+    BinaryHeader header;
+    std::memcpy(header.magic, BinaryMagic, sizeof(BinaryMagic));
+    header.version = BinaryVersion;
+    header.elementType = binaryElementType<T>();
+    header.sorted = std::is_sorted(data.begin(), data.end()) ? 1 : 0;
+    header.count = data.size();
+    header.checksum = binaryChecksum(payload, payloadSize);
+    if (!writeAt(file, reinterpret_cast<const char*>(&header), sizeof(header), 0) || !writeAt(file, payload, payloadSize, sizeof(header))) {
+        std::cerr << "Write failed: " << path << std::endl;
     }
+    CloseHandle(file);
+}
 
-private:
-    void updateValueText() {
-        std::ostringstream oss;
-        oss << std::fixed << std::setprecision(0) << currentValue;
-        valueText.setString(oss.str());
+// Writes data as comma-separated text, or in the binary format when the path ends in .bin.
+// Floating values use the shortest form that reads back exactly.
+// Each thread measures the text of its slice of data; the prefix sums give the file size and every slice's
+// offset, and the threads then format straight into a writable mapping of the file. Positional WriteFile
+// calls from several threads would not overlap on NTFS, where a write past the valid data length zero-fills
+// the gap and completes synchronously. Small outputs run the same steps on one thread.
+template <typename T>
+void writeNumbersToFile(const std::string& path, const std::vector<T>& data, unsigned threadCount = defaultThreadCount()) {
+    if (hasBinaryExtension(path)) {
+        writeNumbersToBinaryFile(path, data);
+        return;
+    }
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "     : " << path << std::endl;
+        return;
     }
 
-    sf::RectangleShape track;
-    sf::RectangleShape knob;
-    sf::Text valueText;
-    int minValue;
-    int maxValue;
-    int currentValue;
-    bool isDragging;
-};
+    if (data.size() < ParallelWriteMinValues) {
+        threadCount = 1;
+    }
+    threadCount = std::max(threadCount, 1u);
+    std::vector<unsigned long long> offsets(threadCount + 1, 0);
+    runOnThreads(threadCount, [&](unsigned thread) {
+        size_t first = data.size() * thread / threadCount;
+        size_t last = data.size() * (thread + 1) / threadCount;
+        offsets[thread + 1] = formattedLength(data.data() + first, data.data() + last) + (first != 0 && first != last ? 1 : 0);
+    });
+    for (unsigned thread = 0; thread < threadCount; ++thread) {
+        offsets[thread + 1] += offsets[thread];
+    }
 
-struct Node {
-    int value;
-    Node* left = nullptr;
-    Node* right = nullptr;
-    Node* parent = nullptr;
-};
+    unsigned long long fileSize = offsets[threadCount];
+    bool written = true;
+    if (fileSize != 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, static_cast<DWORD>(fileSize >> 32), static_cast<DWORD>(fileSize), NULL);
+        char* view = nullptr;
+        if (mapping != NULL) {
+            view = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, static_cast<size_t>(fileSize)));
+        }
+        written = view != nullptr;
+        if (written) {
+            runOnThreads(threadCount, [&](unsigned thread) {
+                size_t first = data.size() * thread / threadCount;
+                size_t last = data.size() * (thread + 1) / threadCount;
+                formatNumbers(data.data() + first, data.data() + last, first != 0, view + offsets[thread], view + offsets[thread + 1]);
+            });
+            UnmapViewOfFile(view);
+        }
+        if (mapping != NULL) {
+            CloseHandle(mapping);
+        }
+    }
+    if (!written) {
+        std::cerr << "Write failed: " << path << std::endl;
+    }
+    CloseHandle(file);
+}
 
-Node* createNode(int val, Node* parent = nullptr) {
-    Node* newNode = new Node;
-    newNode->value = val;
-    newNode->parent = parent;
-    return newNode;
+// Converts a numbers file between text and binary; the input format is detected and the output format follows
+// the output extension. Values are read and written as T.
+template <typename T>
+void convertNumbersFile(const std::string& from, const std::string& to) {
+    std::vector<T> numbers;
+    parseNumbersFromFile(from, numbers);
+    writeNumbersToFile(to, numbers);
 }
 
-void insertNode(Node*& root, int val) {
-    if (root == nullptr) {
-        root = createNode(val);
+// Element type that holds every value of path: a binary file keeps its own type, and text becomes Float64 when a
+// token has a fraction, an exponent or nan/inf, Int64 when an integer is outside the int32 range, else Int32.
+uint8_t detectElementType(const std::string& path) {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        return ElementTypes::Int32;
     }
-    else {
-        Node* current = root;
-        Node* parent = nullptr;
-        while (current != nullptr) {
-            parent = current;
-            if (val < current->value) {
-                current = current->left;
+    if (isBinaryNumbersFile(file)) {
+        BinaryHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        return header.elementType;
+    }
+    uint8_t elementType = ElementTypes::Int32;
+    size_t digits = 0;
+    unsigned long long magnitude = 0;
+    unsigned long long limit = 0;
+    for (const char* p = file.data(); p != file.data() + file.size(); ++p) {
+        char c = *p;
+        if (c >= '0' && c <= '9') {
+            if (digits++ == 0) {
+                limit = p != file.data() && p[-1] == '-' ? 2147483648ULL : 2147483647ULL;
             }
-            else {
-                current = current->right;
+            if (digits <= 10) {
+                magnitude = magnitude * 10 + (c - '0');
+            }
+            if (digits > 10 || magnitude > limit) {
+                elementType = ElementTypes::Int64;
             }
         }
-        if (val < parent->value) {
-            parent->left = createNode(val, parent);
+        else if (c == '.' || c == 'e' || c == 'E' || c == 'n' || c == 'N' || c == 'i' || c == 'I') {
+            return ElementTypes::Float64;
         }
         else {
-            parent->right = createNode(val, parent);
+            digits = 0;
+            magnitude = 0;
         }
     }
+    return elementType;
 }
 
-Node* buildBinarySortTree(const std::vector<int>& arr) {
-    Node* root = nullptr;
-    for (int val : arr) {
-        insertNode(root, val);
+// Maps "int32", "int64", "float32" or "float64" to its element type, or returns 0.
+uint8_t elementTypeFromName(const std::string& name) {
+    const char* names[4] = { "int32", "int64", "float32", "float64" };
+    const uint8_t types[4] = { ElementTypes::Int32, ElementTypes::Int64, ElementTypes::Float32, ElementTypes::Float64 };
+    for (int i = 0; i < 4; ++i) {
+        if (name == names[i]) {
+            return types[i];
+        }
     }
-    return root;
+    return 0;
 }
 
-void collectSortedValues(Node* root, std::vector<int>& sortedArray) {
-    if (root != nullptr) {
-        collectSortedValues(root->left, sortedArray);
-        sortedArray.push_back(root->value);
-        collectSortedValues(root->right, sortedArray);
+// Converts with the given element type, or with detectElementType(from) when it is 0, so converting a file
+// loses nothing unless a narrower type is asked for.
+void convertNumbersFile(const std::string& from, const std::string& to, uint8_t elementType = 0) {
+    if (elementType == 0) {
+        elementType = detectElementType(from);
+    }
+    if (elementType == ElementTypes::Int64) {
+        convertNumbersFile<int64_t>(from, to);
+    }
+    else if (elementType == ElementTypes::Float32) {
+        convertNumbersFile<float>(from, to);
+    }
+    else if (elementType == ElementTypes::Float64) {
+        convertNumbersFile<double>(from, to);
+    }
+    else {
+        convertNumbersFile<int32_t>(from, to);
     }
 }
 
-std::vector<int> binaryTreeSort(const std::vector<int>& arr) {
-    Node* root = buildBinarySortTree(arr);
-    std::vector<int> sortedArray;
-    collectSortedValues(root, sortedArray);
-    return sortedArray;
+void openFile(const wchar_t* relativePath) {
+    wchar_t absolutePath[MAX_PATH];
+    GetFullPathName(relativePath, MAX_PATH, absolutePath, NULL);
+    HINSTANCE result = ShellExecute(NULL, L"open", absolutePath, NULL, NULL, SW_SHOWNORMAL);
+}
+
+std::vector<int> generateNumbers(int numElements, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::vector<int> numbers;
+    numbers.reserve(numElements);
+    for (int i = 0; i < numElements; ++i) {
+        int number = static_cast<int>(generator() % 10000) * 10 + static_cast<int>(generator() % 10);
+        if (generator() % 2 == 0) {
+            number *= -1;
+        }
+        numbers.push_back(number);
+    }
+    return numbers;
 }
 
-void parseNumbersFromFile(const std::string& path, std::vector<int>& numbers) {
-    std::ifstream file(path);
+template <typename Function>
+double measureSeconds(Function function) {
+    sf::Clock clock;
+    function();
+    return clock.getElapsedTime().asSeconds();
+}
 
-    if (!file.is_open()) {
-        std::cerr << "Could not open the file " << path << std::endl;
-        return;
+void printBenchmarkLine(const std::string& label, double seconds, size_t numValues) {
+    std::cout << "  " << std::left << std::setw(20) << label << std::right
+        << "  time: " << std::fixed << std::setprecision(3) << seconds << " sec"
+        << "  (" << std::setprecision(1) << numValues / std::max(seconds, 1e-6) / 1e6 << " M values/sec)" << std::endl;
+}
+
+void benchmarkNodeAllocation(const std::vector<int>& data) {
+    const size_t chunkSizes[2] = { 1, 16384 };
+    for (size_t nodesPerChunk : chunkSizes) {
+        size_t allocations = 0;
+        size_t nodes = 0;
+        double seconds = measureSeconds([&]() {
+            NodeArena arena(nodesPerChunk);
+            Node* root = buildBinarySortTree(data, arena);
+            std::vector<int> sortedArray(data.size());
+            collectSortedValues(root, sortedArray.data());
+            allocations = arena.getChunkCount();
+            nodes = arena.getNodeCount();
+        });
+        printBenchmarkLine(nodesPerChunk == 1 ? "per-node new" : "node arena", seconds, data.size());
+        std::cout << "                        allocations: " << allocations << "  nodes: " << nodes << std::endl;
     }
+}
 
-    std::string line;
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string item;
-        while (std::getline(ss, item, ',')) {
-            try {
-                numbers.push_back(std::stoi(item));
-            }
-            catch (const std::invalid_argument& e) {
-                std::cerr << "Invalid number: " << item << std::endl;
+void benchmarkTreeLayout(const std::vector<int>& data) {
+    double seconds = measureSeconds([&]() { binaryTreeSort(data, SortModes::Basic); });
+    printBenchmarkLine("pointer nodes", seconds, data.size());
+    std::cout << "                        node size: " << sizeof(Node) << " bytes" << std::endl;
+    seconds = measureSeconds([&]() { binaryTreeSort(data, SortModes::Compact); });
+    printBenchmarkLine("index nodes", seconds, data.size());
+    std::cout << "                        node size: " << sizeof(CompactNode) << " bytes" << std::endl;
+    seconds = measureSeconds([&]() { binaryTreeSort(data, SortModes::WideNode); });
+    printBenchmarkLine("wide nodes", seconds, data.size());
+    std::cout << "                        node size: " << sizeof(BTreeNode) << " bytes, " << BTreeMaxKeys << " keys" << std::endl;
+}
+
+void benchmarkBalancedTrees(const std::vector<int>& randomData) {
+    std::vector<int> ascendingData = randomData;
+    std::sort(ascendingData.begin(), ascendingData.end());
+    std::vector<int> descendingData(ascendingData.rbegin(), ascendingData.rend());
+
+    const std::string inputNames[3] = { "random", "ascending", "descending" };
+    const std::vector<int>* inputs[3] = { &randomData, &ascendingData, &descendingData };
+    const std::string modeNames[4] = { "red-black", "avl", "scapegoat", "treap" };
+    const int modes[4] = { SortModes::RedBlack, SortModes::Avl, SortModes::Scapegoat, SortModes::Treap };
+    for (int i = 0; i < 3; ++i) {
+        std::cout << "Balanced trees, " << inputs[i]->size() << " " << inputNames[i] << " values" << std::endl;
+        for (int j = 0; j < 4; ++j) {
+            double seconds = measureSeconds([&]() { sortWithEngine(*inputs[i], modes[j], DefaultTreapSeed); });
+            printBenchmarkLine(modeNames[j], seconds, inputs[i]->size());
+        }
+    }
+}
+
+void benchmarkRelayout(const std::vector<int>& data) {
+    const int traversals = 10;
+    const std::string layoutNames[3] = { "arena order", "in-order", "van Emde Boas" };
+    for (int layout = -1; layout <= TreeLayouts::VanEmdeBoas; ++layout) {
+        NodeArena arena;
+        std::vector<Node> block;
+        Node* root = buildBinarySortTree(data, arena);
+        if (layout >= 0) {
+            root = relayoutTree(root, block, layout);
+        }
+        double seconds = measureSeconds([&]() {
+            for (int i = 0; i < traversals; ++i) {
+                std::vector<int> sortedArray(data.size());
+                collectSortedValues(root, sortedArray.data());
             }
-            catch (const std::out_of_range& e) {
-                std::cerr << "Number out of range: " << item << std::endl;
+        });
+        printBenchmarkLine(layoutNames[layout + 1] + " scan", seconds, data.size() * traversals);
+        size_t found = 0;
+        seconds = measureSeconds([&]() {
+            for (int val : data) {
+                found += findNode(root, val) != nullptr;
             }
-        }
+        });
+        printBenchmarkLine(layoutNames[layout + 1] + " find", seconds, found);
     }
+}
 
-    file.close();
+void benchmarkFingerInsertion(const std::vector<int>& randomData) {
+    std::vector<int> nearlySortedData(randomData.begin(), randomData.begin() + std::min<size_t>(randomData.size(), 100000));
+    std::sort(nearlySortedData.begin(), nearlySortedData.end());
+    std::mt19937 generator(54321);
+    for (size_t i = 0; i < nearlySortedData.size() / 100; ++i) {
+        std::swap(nearlySortedData[generator() % nearlySortedData.size()], nearlySortedData[generator() % nearlySortedData.size()]);
+    }
+    std::cout << "Finger insertion, " << nearlySortedData.size() << " nearly sorted values" << std::endl;
+    const std::string modeNames[3] = { "basic", "finger", "red-black" };
+    const int modes[3] = { SortModes::Basic, SortModes::Finger, SortModes::RedBlack };
+    for (int i = 0; i < 3; ++i) {
+        double seconds = measureSeconds([&]() { sortWithEngine(nearlySortedData, modes[i], DefaultTreapSeed); });
+        printBenchmarkLine(modeNames[i], seconds, nearlySortedData.size());
+    }
 }
 
-void generateNumbersFile(const std::string& path, int numElements) {
-    std::ofstream outFile(path);
-    if (!outFile) {
-        std::cerr << "Error opening file: " << path << std::endl;
-        return;
+void benchmarkRunDetection(const std::vector<int>& randomData) {
+    std::vector<int> ascendingData = randomData;
+    std::sort(ascendingData.begin(), ascendingData.end());
+    std::vector<int> descendingData(ascendingData.rbegin(), ascendingData.rend());
+    std::vector<int> fourRunData = randomData;
+    for (int run = 0; run < 4; ++run) {
+        std::sort(fourRunData.begin() + fourRunData.size() * run / 4, fourRunData.begin() + fourRunData.size() * (run + 1) / 4);
     }
 
-    srand(time(NULL));
+    const std::string inputNames[3] = { "ascending", "descending", "four runs" };
+    const std::vector<int>* inputs[3] = { &ascendingData, &descendingData, &fourRunData };
+    for (int i = 0; i < 3; ++i) {
+        std::cout << "Run detection, " << inputs[i]->size() << " values, " << inputNames[i] << std::endl;
+        double seconds = measureSeconds([&]() { sortWithEngine(*inputs[i], SortModes::RedBlack, DefaultTreapSeed); });
+        printBenchmarkLine("red-black tree", seconds, inputs[i]->size());
+        seconds = measureSeconds([&]() { binaryTreeSort(*inputs[i], SortModes::RedBlack); });
+        printBenchmarkLine("run detection", seconds, inputs[i]->size());
+    }
+}
 
-    for (int i = 0; i < numElements; ++i) {
-        int number = (rand() % 10000) * 10 + (rand() % 10);
-        if (rand() % 2 == 0) {
-            number *= -1;
+void benchmarkGenericSort(const std::vector<int>& randomData) {
+    std::vector<long long> wideData(randomData.begin(), randomData.end());
+    for (long long& value : wideData) {
+        value *= 1000003;
+    }
+    std::vector<double> realData(randomData.begin(), randomData.end());
+    for (double& value : realData) {
+        value /= 7.0;
+    }
+    std::cout << "Generic sort, " << randomData.size() << " random values" << std::endl;
+    double seconds = measureSeconds([&]() { sortWithEngine(randomData, SortModes::RedBlack, DefaultTreapSeed); });
+    printBenchmarkLine("int mode", seconds, randomData.size());
+    seconds = measureSeconds([&]() { binaryTreeSort(randomData, std::less<>()); });
+    printBenchmarkLine("int ascending", seconds, randomData.size());
+    seconds = measureSeconds([&]() { binaryTreeSort(randomData, std::greater<>()); });
+    printBenchmarkLine("int descending", seconds, randomData.size());
+    seconds = measureSeconds([&]() { binaryTreeSort(wideData); });
+    printBenchmarkLine("int64", seconds, wideData.size());
+    seconds = measureSeconds([&]() { binaryTreeSort(realData); });
+    printBenchmarkLine("double", seconds, realData.size());
+}
+
+void benchmarkRecordSort(const std::vector<int>& randomData) {
+    std::vector<std::pair<int, uint64_t>> records;
+    records.reserve(randomData.size());
+    for (size_t i = 0; i < randomData.size(); ++i) {
+        records.push_back({ randomData[i], i * 64 });
+    }
+    std::cout << "Record sort, " << randomData.size() << " (key, payload offset) records" << std::endl;
+    double seconds = measureSeconds([&]() {
+        binaryTreeSort(records, std::less<>(), [](const std::pair<int, uint64_t>& record) { return record.first; });
+    });
+    printBenchmarkLine("records in tree", seconds, records.size());
+    std::vector<int> keys = randomData;
+    std::vector<uint64_t> payloads;
+    for (const std::pair<int, uint64_t>& record : records) {
+        payloads.push_back(record.second);
+    }
+    seconds = measureSeconds([&]() { binaryTreeSortRecords(keys, payloads); });
+    printBenchmarkLine("separate keys", seconds, keys.size());
+}
+
+void benchmarkBoundedSort(const std::vector<int>& randomData) {
+    std::cout << "Bounded sort, " << randomData.size() << " random values" << std::endl;
+    double seconds = measureSeconds([&]() { sortWithEngine(randomData, SortModes::Treap, DefaultTreapSeed); });
+    printBenchmarkLine("full treap", seconds, randomData.size());
+    const size_t bounds[3] = { 100, 10000, 100000 };
+    for (size_t k : bounds) {
+        seconds = measureSeconds([&]() { binaryTreeSortBounded(randomData, k); });
+        printBenchmarkLine("smallest " + std::to_string(k), seconds, randomData.size());
+        seconds = measureSeconds([&]() { binaryTreeSortBounded(randomData, k, true); });
+        printBenchmarkLine("largest " + std::to_string(k), seconds, randomData.size());
+    }
+}
+
+void benchmarkLazyIteration(const std::vector<int>& randomData) {
+    std::cout << "Lazy iteration, " << randomData.size() << " random values" << std::endl;
+    SortTree tree(randomData);
+    volatile long long sum = 0;
+    double seconds = measureSeconds([&]() {
+        std::vector<int> sortedArray = binaryTreeSort(randomData, SortModes::Finger);
+        for (size_t i = 0; i < 1000; ++i) {
+            sum += sortedArray[i];
         }
-        outFile << number;
-        if (i < numElements - 1) {
-            outFile << ",";
+    });
+    printBenchmarkLine("first 1000, full", seconds, 1000);
+    seconds = measureSeconds([&]() {
+        SortTree::Iterator it = tree.begin();
+        for (size_t i = 0; i < 1000; ++i, ++it) {
+            sum += *it;
+        }
+    });
+    printBenchmarkLine("first 1000, lazy", seconds, 1000);
+    size_t inRange = 0;
+    seconds = measureSeconds([&]() {
+        for (SortTree::Iterator it = tree.lower_bound(-1000), last = tree.upper_bound(1000); it != last; ++it) {
+            ++inRange;
+        }
+    });
+    printBenchmarkLine("range [-1000, 1000]", seconds, inRange);
+}
+
+void benchmarkOrderStatistics(const std::vector<int>& randomData) {
+    std::cout << "Order statistics, " << randomData.size() << " random values, 1000 x p50/p90/p99" << std::endl;
+    SortTree tree(randomData);
+    volatile long long sum = 0;
+    double seconds = measureSeconds([&]() {
+        for (int i = 0; i < 3; ++i) {
+            std::vector<int> sortedArray = binaryTreeSort(randomData, SortModes::Finger);
+            sum += sortedArray[sortedArray.size() / 2] + sortedArray[sortedArray.size() * 9 / 10] + sortedArray[sortedArray.size() * 99 / 100];
+        }
+    });
+    printBenchmarkLine("re-sort x3", seconds, 9);
+    seconds = measureSeconds([&]() {
+        for (int i = 0; i < 1000; ++i) {
+            sum += tree.percentile(50) + tree.percentile(90) + tree.percentile(99);
+        }
+    });
+    printBenchmarkLine("SortTree x1000", seconds, 3000);
+}
+
+void benchmarkSlidingWindow(const std::vector<int>& randomData) {
+    const size_t window = 1000;
+    const std::vector<int> stream(randomData.begin(), randomData.begin() + 20000);
+    std::cout << "Sliding window median, " << stream.size() << " samples, window " << window << std::endl;
+    volatile long long sum = 0;
+    double seconds = measureSeconds([&]() {
+        std::vector<int> windowValues;
+        for (size_t i = 0; i < stream.size(); ++i) {
+            windowValues.assign(stream.begin() + (i < window ? 0 : i + 1 - window), stream.begin() + i + 1);
+            std::sort(windowValues.begin(), windowValues.end());
+            sum += windowValues[(windowValues.size() - 1) / 2];
         }
+    });
+    printBenchmarkLine("re-sort window", seconds, stream.size());
+    seconds = measureSeconds([&]() {
+        for (int median : slidingWindowPercentiles(stream, window)) {
+            sum += median;
+        }
+    });
+    printBenchmarkLine("erase + insert", seconds, stream.size());
+}
+
+void benchmarkParallelSort(const std::vector<int>& randomData) {
+    std::cout << "Parallel sample sort, " << randomData.size() << " random values, " << defaultThreadCount() << " hardware threads" << std::endl;
+    std::vector<int> skewedData = randomData;
+    for (size_t i = 0; i < skewedData.size(); i += 2) {
+        skewedData[i] = 42;
+    }
+    double seconds = measureSeconds([&]() { sortWithEngine(randomData, SortModes::Finger, DefaultTreapSeed); });
+    printBenchmarkLine("finger, 1 thread", seconds, randomData.size());
+    for (unsigned threadCount = 1; threadCount <= std::max(defaultThreadCount(), 8u); threadCount *= 2) {
+        std::vector<int> sortedArray;
+        seconds = measureSeconds([&]() { sortParallelSamples(randomData, sortedArray, threadCount); });
+        printBenchmarkLine(std::to_string(threadCount) + " threads", seconds, randomData.size());
+        seconds = measureSeconds([&]() { sortParallelSamples(skewedData, sortedArray, threadCount); });
+        printBenchmarkLine(std::to_string(threadCount) + " threads, skewed", seconds, skewedData.size());
     }
+}
 
-    outFile.close();
+void benchmarkChunkMerge(const std::vector<int>& randomData) {
+    std::cout << "Chunk trees + loser-tree merge, " << randomData.size() << " random values, " << defaultThreadCount() << " hardware threads" << std::endl;
+    double seconds = measureSeconds([&]() { binaryTreeSort(randomData); });
+    printBenchmarkLine("binaryTreeSort", seconds, randomData.size());
+    for (unsigned threadCount = 1; threadCount <= std::max(defaultThreadCount(), 8u); threadCount *= 2) {
+        std::vector<int> sortedArray;
+        seconds = measureSeconds([&]() { sortParallelChunks(randomData, sortedArray, threadCount); });
+        printBenchmarkLine(std::to_string(threadCount) + " threads", seconds, randomData.size());
+    }
 }
 
-void writeNumbersToFile(const std::string& path, const std::vector<int>& data) {
-    std::ofstream outFile(path);
-    if (!outFile.is_open()) {
-        std::cerr << "     : " << path << std::endl;
-        return;
+void benchmarkConcurrentInsertion(const std::vector<int>& randomData) {
+    std::cout << "Shared tree insertion, " << randomData.size() << " random values, " << defaultThreadCount() << " hardware threads" << std::endl;
+    for (unsigned producers = 1; producers <= std::max(defaultThreadCount(), 8u); producers *= 2) {
+        double seconds = measureSeconds([&]() {
+            NodeArena arena;
+            Node* root = nullptr;
+            std::mutex treeMutex;
+            runOnThreads(producers, [&](unsigned producer) {
+                for (size_t i = producer; i < randomData.size(); i += producers) {
+                    std::lock_guard<std::mutex> lock(treeMutex);
+                    insertNode(root, randomData[i], arena);
+                }
+            });
+        });
+        printBenchmarkLine(std::to_string(producers) + " threads, mutex", seconds, randomData.size());
+        seconds = measureSeconds([&]() {
+            ConcurrentTree tree(producers);
+            runOnThreads(producers, [&](unsigned producer) {
+                for (size_t i = producer; i < randomData.size(); i += producers) {
+                    tree.insert(randomData[i], producer);
+                }
+            });
+        });
+        printBenchmarkLine(std::to_string(producers) + " threads, CAS", seconds, randomData.size());
     }
+}
 
-    for (size_t i = 0; i < data.size(); ++i) {
-        outFile << data[i];
-        if (i < data.size() - 1) {
-            outFile << ",";
+void benchmarkParallelCollect(const std::vector<int>& randomData) {
+    std::cout << "Parallel in-order collect, " << randomData.size() << " random values, " << defaultThreadCount() << " hardware threads" << std::endl;
+    SizedNodeArena arena;
+    SizedNode* root = buildBinarySortTree(randomData, arena);
+    std::vector<int> sortedArray(randomData.size());
+    double seconds = measureSeconds([&]() { collectSortedValues(root, sortedArray.data()); });
+    printBenchmarkLine("serial", seconds, randomData.size());
+    for (unsigned threadCount = 2; threadCount <= std::max(defaultThreadCount(), 8u); threadCount *= 2) {
+        seconds = measureSeconds([&]() { collectSortedValuesParallel(root, sortedArray.data(), threadCount); });
+        printBenchmarkLine(std::to_string(threadCount) + " threads", seconds, randomData.size());
+    }
+    seconds = measureSeconds([&]() { sortWithEngine(randomData, SortModes::Basic, DefaultTreapSeed); });
+    printBenchmarkLine("basic sort", seconds, randomData.size());
+    seconds = measureSeconds([&]() { sortWithEngine(randomData, SortModes::ParallelCollect, DefaultTreapSeed); });
+    printBenchmarkLine("parallel collect sort", seconds, randomData.size());
+}
+
+void benchmarkParsing(const std::vector<int>& randomData) {
+    const std::string path = "benchmark_numbers.txt";
+    writeNumbersToFile(path, randomData);
+    size_t fileSize = MappedFile(path).size();
+    std::cout << "Parsing, " << randomData.size() << " values, " << fileSize / (1024 * 1024) << " MB" << std::endl;
+    double seconds = measureSeconds([&]() {
+        std::vector<int> numbers;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::stringstream ss(line);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                numbers.push_back(std::stoi(item));
+            }
         }
+    });
+    printBenchmarkLine("getline + stoi", seconds, randomData.size());
+    for (unsigned threadCount = 1; threadCount <= std::max(defaultThreadCount(), 8u); threadCount *= 2) {
+        seconds = measureSeconds([&]() {
+            std::vector<int> numbers;
+            parseNumbersFromFile(path, numbers, threadCount);
+        });
+        printBenchmarkLine("mapped, " + std::to_string(threadCount) + " threads", seconds, randomData.size());
+        std::cout << "  " << std::fixed << std::setprecision(2) << fileSize / std::max(seconds, 1e-6) / 1e9 << " GB/s" << std::endl;
     }
+    std::remove(path.c_str());
+}
 
-    outFile.close();
+void benchmarkFileSort(const std::vector<int>& randomData) {
+    const std::string path = "benchmark_numbers.txt";
+    writeNumbersToFile(path, randomData);
+    std::cout << "File to sorted vector, " << randomData.size() << " random values" << std::endl;
+    double seconds = measureSeconds([&]() {
+        std::vector<int> data;
+        parseNumbersFromFile(path, data);
+        binaryTreeSort(data);
+    });
+    printBenchmarkLine("parse, then sort", seconds, randomData.size());
+    seconds = measureSeconds([&]() { binaryTreeSortFile(path); });
+    printBenchmarkLine("fused", seconds, randomData.size());
+    std::remove(path.c_str());
 }
 
-void openFile(const wchar_t* relativePath) {
-    wchar_t absolutePath[MAX_PATH];
-    GetFullPathName(relativePath, MAX_PATH, absolutePath, NULL);
-    HINSTANCE result = ShellExecute(NULL, L"open", absolutePath, NULL, NULL, SW_SHOWNORMAL);
+void benchmarkWriting(const std::vector<int>& randomData) {
+    const std::string path = "benchmark_numbers.txt";
+    std::cout << "Writing, " << randomData.size() << " values" << std::endl;
+    double seconds = measureSeconds([&]() {
+        std::ofstream outFile(path);
+        for (size_t i = 0; i < randomData.size(); ++i) {
+            outFile << randomData[i];
+            if (i < randomData.size() - 1) {
+                outFile << ",";
+            }
+        }
+    });
+    printBenchmarkLine("ofstream <<", seconds, randomData.size());
+    for (unsigned threadCount = 1; threadCount <= std::max(defaultThreadCount(), 8u); threadCount *= 2) {
+        seconds = measureSeconds([&]() { writeNumbersToFile(path, randomData, threadCount); });
+        printBenchmarkLine("to_chars, " + std::to_string(threadCount) + " threads", seconds, randomData.size());
+    }
+    std::remove(path.c_str());
+}
+
+void benchmarkBinaryFormat(const std::vector<int>& randomData) {
+    const std::string textPath = "benchmark_numbers.txt";
+    const std::string binaryPath = "benchmark_numbers.bin";
+    std::vector<int> sortedData = binaryTreeSort(randomData, SortModes::ParallelSample);
+    std::cout << "Text vs binary, " << sortedData.size() << " sorted values" << std::endl;
+    double seconds = measureSeconds([&]() { writeNumbersToFile(textPath, sortedData); });
+    printBenchmarkLine("write text", seconds, sortedData.size());
+    seconds = measureSeconds([&]() { writeNumbersToFile(binaryPath, sortedData); });
+    printBenchmarkLine("write binary", seconds, sortedData.size());
+    seconds = measureSeconds([&]() {
+        std::vector<int> numbers;
+        parseNumbersFromFile(textPath, numbers);
+    });
+    printBenchmarkLine("read text", seconds, sortedData.size());
+    seconds = measureSeconds([&]() {
+        std::vector<int> numbers;
+        parseNumbersFromFile(binaryPath, numbers);
+    });
+    printBenchmarkLine("read binary", seconds, sortedData.size());
+    volatile long long sum = 0;
+    seconds = measureSeconds([&]() {
+        MappedNumbers<int> numbers(binaryPath);
+        sum += numbers[numbers.size() / 2];
+    });
+    printBenchmarkLine("open mapped, median", seconds, sortedData.size());
+    std::remove(textPath.c_str());
+    std::remove(binaryPath.c_str());
+}
+
+void runBenchmarks() {
+    std::vector<int> randomData = generateNumbers(1000000, 12345);
+    std::cout << "Node allocation, " << randomData.size() << " random values" << std::endl;
+    benchmarkNodeAllocation(randomData);
+    std::cout << "Tree layout, " << randomData.size() << " random values" << std::endl;
+    benchmarkTreeLayout(randomData);
+    benchmarkBalancedTrees(randomData);
+    std::cout << "Tree relayout, " << randomData.size() << " random values" << std::endl;
+    benchmarkRelayout(randomData);
+    benchmarkFingerInsertion(randomData);
+    benchmarkRunDetection(randomData);
+    benchmarkGenericSort(randomData);
+    benchmarkRecordSort(randomData);
+    benchmarkBoundedSort(randomData);
+    benchmarkLazyIteration(randomData);
+    benchmarkOrderStatistics(randomData);
+    benchmarkSlidingWindow(randomData);
+    benchmarkParallelSort(randomData);
+    benchmarkChunkMerge(randomData);
+    benchmarkConcurrentInsertion(randomData);
+    benchmarkParallelCollect(randomData);
+    benchmarkParsing(randomData);
+    benchmarkFileSort(randomData);
+    benchmarkWriting(randomData);
+    benchmarkBinaryFormat(randomData);
+}
+
+struct SelfTestInput {
+    std::string name;
+    std::vector<int> values;
+    bool presorted;
+};
+
+// Edge cases for --selftest, with sizes just above the thresholds where the parallel paths take over.
+std::vector<SelfTestInput> selfTestInputs() {
+    std::mt19937 generator(20240);
+    std::vector<SelfTestInput> inputs;
+    inputs.push_back({ "empty", {}, false });
+    inputs.push_back({ "single", { 42 }, false });
+    inputs.push_back({ "extremes", { INT_MAX, INT_MIN, 0, INT_MAX, -1, INT_MIN, 1 }, false });
+    inputs.push_back({ "all duplicates", std::vector<int>(ParallelSortMinSize + 1, 7), false });
+
+    std::vector<int> random(ParallelSortMinSize + 1);
+    for (int& val : random) {
+        val = static_cast<int>(generator());
+    }
+    random[0] = INT_MIN;
+    random[random.size() / 2] = INT_MAX;
+    inputs.push_back({ "random", random, false });
+
+    std::vector<int> fewDistinct(ParallelSortMinSize + 17);
+    for (int& val : fewDistinct) {
+        val = static_cast<int>(generator() % 5) - 2;
+    }
+    inputs.push_back({ "few distinct", fewDistinct, false });
+
+    std::sort(random.begin(), random.end());
+    inputs.push_back({ "ascending", random, true });
+    std::reverse(random.begin(), random.end());
+    inputs.push_back({ "descending", random, true });
+
+    // About 11 bytes of text per value, so the text file is above ParallelParseMinBytes.
+    std::vector<int> large(ParallelParseMinBytes / 8);
+    for (int& val : large) {
+        val = static_cast<int>(generator());
+    }
+    inputs.push_back({ "large", large, false });
+    return inputs;
+}
+
+class SelfTest {
+public:
+    void check(bool passed, const std::string& label) {
+        ++checks;
+        if (!passed) {
+            ++failures;
+            std::cerr << "FAILED: " << label << std::endl;
+        }
+    }
+
+    // Every sort path against std::sort. Presorted inputs skip the paths that insert from the root without
+    // balancing, which would take quadratic time on them; binaryTreeSort still covers them through run detection.
+    void checkSorting(const SelfTestInput& input) {
+        const std::vector<int>& values = input.values;
+        std::vector<int> expected = values;
+        std::sort(expected.begin(), expected.end());
+        for (int mode = SortModes::Basic; mode <= SortModes::ParallelCollect; ++mode) {
+            check(binaryTreeSort(values, mode) == expected, input.name + ", binaryTreeSort mode " + std::to_string(mode));
+            if (!input.presorted) {
+                check(sortWithEngine(values, mode, DefaultTreapSeed) == expected, input.name + ", engine mode " + std::to_string(mode));
+            }
+        }
+
+        const unsigned threadCounts[4] = { 1, 2, 3, 16 };
+        for (unsigned threadCount : threadCounts) {
+            std::string suffix = ", " + std::to_string(threadCount) + " threads";
+            std::vector<int> sortedArray;
+            sortParallelSamples(values, sortedArray, threadCount);
+            check(sortedArray == expected, input.name + ", sortParallelSamples" + suffix);
+            sortedArray.clear();
+            sortParallelChunks(values, sortedArray, threadCount);
+            check(sortedArray == expected, input.name + ", sortParallelChunks" + suffix);
+            if (input.presorted) {
+                continue;
+            }
+
+            ConcurrentTree tree(threadCount);
+            runOnThreads(threadCount, [&](unsigned producer) {
+                for (size_t i = producer; i < values.size(); i += threadCount) {
+                    tree.insert(values[i], producer);
+                }
+            });
+            sortedArray.clear();
+            tree.collectSortedValues(sortedArray);
+            check(sortedArray == expected, input.name + ", ConcurrentTree" + suffix);
+
+            SizedNodeArena arena;
+            SizedNode* root = buildBinarySortTree(values, arena);
+            sortedArray.assign(values.size(), 0);
+            int* end = collectSortedValuesParallel(root, sortedArray.data(), threadCount);
+            check(end == sortedArray.data() + values.size() && sortedArray == expected, input.name + ", collectSortedValuesParallel" + suffix);
+        }
+    }
+
+    // The writer and the parser must give back the values they were given, in both formats.
+    void checkFiles(const SelfTestInput& input) {
+        const std::string textPath = "selftest_numbers.txt";
+        const std::string binaryPath = "selftest_numbers.bin";
+        std::vector<int> expected = input.values;
+        std::sort(expected.begin(), expected.end());
+        const unsigned threadCounts[3] = { 1, 3, 16 };
+        for (unsigned threadCount : threadCounts) {
+            std::string suffix = ", " + std::to_string(threadCount) + " threads";
+            writeNumbersToFile(textPath, input.values, threadCount);
+            std::vector<int> numbers;
+            parseNumbersFromFile(textPath, numbers, threadCount);
+            check(numbers == input.values, input.name + ", text round trip" + suffix);
+        }
+        check(binaryTreeSortFile(textPath) == expected, input.name + ", binaryTreeSortFile text");
+        writeNumbersToFile(binaryPath, input.values);
+        std::vector<int> numbers;
+        parseNumbersFromFile(binaryPath, numbers);
+        check(numbers == input.values, input.name + ", binary round trip");
+        check(binaryTreeSortFile(binaryPath) == expected, input.name + ", binaryTreeSortFile binary");
+        std::remove(textPath.c_str());
+        std::remove(binaryPath.c_str());
+    }
+
+    void checkFloatingFiles() {
+        const std::string path = "selftest_numbers.txt";
+        std::mt19937 generator(20241);
+        std::vector<double> values(ParallelWriteMinValues + 1);
+        for (double& val : values) {
+            val = std::ldexp(static_cast<double>(generator()), static_cast<int>(generator() % 200) - 100) * (generator() % 2 == 0 ? 1 : -1);
+        }
+        values[0] = std::numeric_limits<double>::max();
+        values[1] = -std::numeric_limits<double>::denorm_min();
+        values[2] = 0.1;
+        for (unsigned threadCount : { 1u, 3u }) {
+            writeNumbersToFile(path, values, threadCount);
+            std::vector<double> numbers;
+            parseNumbersFromFile(path, numbers, threadCount);
+            check(numbers == values, "doubles, text round trip, " + std::to_string(threadCount) + " threads");
+        }
+        std::remove(path.c_str());
+    }
+
+    bool report() const {
+        std::cout << "Self test: " << checks << " checks, " << failures << " failed" << std::endl;
+        return failures == 0;
+    }
+
+private:
+    size_t checks = 0;
+    size_t failures = 0;
+};
+
+bool runSelfTests() {
+    SelfTest test;
+    for (const SelfTestInput& input : selfTestInputs()) {
+        test.checkSorting(input);
+        test.checkFiles(input);
+    }
+    test.checkFloatingFiles();
+    return test.report();
 }
 
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        runBenchmarks();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--selftest") {
+        return runSelfTests() ? 0 : 1;
+    }
+    if (argc > 3 && std::string(argv[1]) == "--convert") {
+        uint8_t elementType = argc > 4 ? elementTypeFromName(argv[4]) : 0;
+        if (argc > 4 && elementType == 0) {
+            std::cerr << "Unknown element type " << argv[4] << ", expected int32, int64, float32 or float64" << std::endl;
+            return 1;
+        }
+        convertNumbersFile(argv[2], argv[3], elementType);
+        return 0;
+    }
 
     sf::RenderWindow window(sf::VideoMode(1100, 700), "Menu");
     sf::Color bgColor(192, 192, 192);
@@ -354,10 +3761,8 @@ int main() {
                         if (mainMenu[i].getGlobalBounds().contains(mousePos.x, mousePos.y)) {
                             if (i == 0) {
 
-                                std::vector<int> data;
                                 clock.restart();
-                                parseNumbersFromFile("../Dependencies/FILES/UnsortedSet1.txt", data);
-                                std::vector<int> sortedData = binaryTreeSort(data);
+                                std::vector<int> sortedData = binaryTreeSortFile("../Dependencies/FILES/UnsortedSet1.txt");
                                 elapsed = clock.getElapsedTime();
 
                                 writeNumbersToFile("../Dependencies/FILES/SortedSet1.txt", sortedData);
@@ -387,10 +3792,8 @@ int main() {
                         if (mainMenu[i].getGlobalBounds().contains(mousePos.x, mousePos.y)) {
                             if (i == 0) {
 
-                                std::vector<int> data;
                                 clock.restart();
-                                parseNumbersFromFile("../Dependencies/FILES/UnsortedSet2.txt", data);
-                                std::vector<int> sortedData = binaryTreeSort(data);
+                                std::vector<int> sortedData = binaryTreeSortFile("../Dependencies/FILES/UnsortedSet2.txt");
                                 elapsed = clock.getElapsedTime();
 
                                 writeNumbersToFile("../Dependencies/FILES/SortedSet2.txt", sortedData);